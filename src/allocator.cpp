@@ -1,52 +1,284 @@
 #include "allocator.h"
 
 #include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+    #include <malloc.h>
+#endif // _WIN32
+#include <stdio.h>
+#include <thread>
 #include "macro.h"
 #include "array.h"
+#include "sema.h"
+#include "vmem.h"
 
 struct BaseAllocator
 {
     virtual ~BaseAllocator() {};
     virtual void* Alloc(size_t bytes) = 0;
     virtual void Free(void* p) = 0;
+    virtual void* Realloc(void* p, size_t oldBytes, size_t newBytes) = 0;
+    virtual void* AllocAligned(size_t bytes, size_t align) = 0;
 };
 
+inline size_t AlignUp(size_t x, size_t align)
+{
+    return (x + align - 1u) & ~(align - 1u);
+}
+
+// reserves its whole range up front and commits pages as the head advances.
+// with decommitFrames > 0, the committed tail above recent usage is handed
+// back to the OS after that many frames without touching it.
+//
+// TEMP_DEBUG 1 prefixes each block with the frame it was made in, checked on
+// Free and Realloc, and poisons memory as it is rewound or reset.
+// TEMP_DEBUG 2 also starts every frame on fresh pages behind an inaccessible
+// guard step and decommits the old frame, so stale pointers fault on access
+// until the arena wraps around. both levels keep a stack of open scope
+// marks and trap when a block from below the innermost one grows.
 struct LinearAllocator : public BaseAllocator
 {
+    static constexpr size_t CommitStep      = 1ul << 16ul;
+    static constexpr size_t HugeCommitStep  = 1ul << 21ul;
+    static constexpr size_t Alignment       = 16;
+#if TEMP_DEBUG
+    static constexpr size_t   HeaderSize    = 16;
+    static constexpr uint32_t HeaderMagic   = 0x7e3a11c5u;
+    static constexpr int32_t  PoisonByte    = 0xdd;
+    static constexpr int32_t  MaxScopes     = 64;
+
+    struct Header
+    {
+        uint32_t frame;
+        uint32_t magic;
+        uint64_t bytes;
+    };
+    static_assert(sizeof(Header) == HeaderSize, "header must keep blocks aligned");
+#else
+    static constexpr size_t HeaderSize      = 0;
+#endif // TEMP_DEBUG
+
     size_t   m_size;
     size_t   m_head;
     uint8_t* m_buffer;
+    size_t   m_committed;
+    size_t   m_step;
+    size_t   m_frameBase;
+    size_t   m_framePeak;
+    size_t   m_quietPeak;
+    int32_t  m_quietFrames;
+    int32_t  m_decommitFrames;
+    uint32_t m_frame;
+#if TEMP_DEBUG
+    size_t   m_scopes[MaxScopes];
+    int32_t  m_scopeCount;
+#endif // TEMP_DEBUG
 
-    inline LinearAllocator(size_t size)
+    inline LinearAllocator(size_t size, int32_t decommitFrames = 0, bool hugePages = false)
     {
-        m_size = size;
+        m_step = hugePages ? HugeCommitStep : CommitStep;
+        m_size = AlignUp(size, m_step);
         m_head = 0;
-        m_buffer = (uint8_t*)malloc(size);
+        m_committed = 0;
+        m_frameBase = 0;
+        m_framePeak = 0;
+        m_quietPeak = 0;
+        m_quietFrames = 0;
+        m_decommitFrames = decommitFrames;
+        m_frame = 0;
+    #if TEMP_DEBUG
+        m_scopeCount = 0;
+    #endif // TEMP_DEBUG
+        m_buffer = (uint8_t*)VirtualMemory::Reserve(m_size);
         Assert(m_buffer);
+        if(hugePages)
+        {
+            VirtualMemory::AdviseHugePages(m_buffer, m_size);
+        }
     }
     ~LinearAllocator() final
     {
-        free(m_buffer);
+        VirtualMemory::Release(m_buffer, m_size);
+    }
+    inline void Commit(size_t head)
+    {
+        size_t target = Min(AlignUp(head, m_step), m_size);
+        VirtualMemory::Commit(m_buffer + m_committed, target - m_committed);
+        m_committed = target;
+    }
+    inline void SetHead(size_t head)
+    {
+        Assert(head <= m_size);
+        m_head = head;
+        if(m_head > m_committed)
+        {
+            Commit(m_head);
+        }
+        m_framePeak = Max(m_framePeak, m_head);
+    }
+    inline size_t FramePeak() const
+    {
+        return m_framePeak - m_frameBase;
     }
+    inline bool Owns(const void* p) const
+    {
+        return (const uint8_t*)p >= m_buffer && (const uint8_t*)p < m_buffer + m_size;
+    }
+#if TEMP_DEBUG
+    inline void Poison(size_t begin, size_t end)
+    {
+        if(end > begin)
+        {
+            memset(m_buffer + begin, PoisonByte, end - begin);
+        }
+    }
+    // traps on blocks from an earlier frame or that were already moved
+    inline void Check(const void* p) const
+    {
+        const Header* header = (const Header*)p - 1;
+        Assert(header->magic == HeaderMagic);
+        Assert(header->frame == m_frame);
+    }
+#endif // TEMP_DEBUG
     inline void* Alloc(size_t bytes) final
     {
-        constexpr size_t align = 16;
-        constexpr size_t alignMask = align - 1u;
-        size_t misalignment = bytes & alignMask;
-        size_t pad = (align - misalignment) & alignMask;
-        bytes += pad;
-        Assert(bytes + m_head <= m_size);
+    #if TEMP_DEBUG
+        return AllocAligned(bytes, Alignment);
+    #else
         void* p = m_buffer + m_head;
-        m_head += bytes;
+        SetHead(m_head + AlignUp(bytes, Alignment));
         return p;
+    #endif // TEMP_DEBUG
+    }
+    inline void* AllocAligned(size_t bytes, size_t align) final
+    {
+        // m_buffer is page aligned, so aligning the offset is enough
+        size_t start = AlignUp(m_head + HeaderSize, Max(align, Alignment));
+        SetHead(start + AlignUp(bytes, Alignment));
+    #if TEMP_DEBUG
+        Header* header = (Header*)(m_buffer + start) - 1;
+        header->frame = m_frame;
+        header->magic = HeaderMagic;
+        header->bytes = bytes;
+    #endif // TEMP_DEBUG
+        return m_buffer + start;
     }
     inline void Free(void* p) final 
     {
-
+    #if TEMP_DEBUG
+        if(p)
+        {
+            Check(p);
+        }
+    #endif // TEMP_DEBUG
+    }
+    inline void* Realloc(void* p, size_t oldBytes, size_t newBytes) final
+    {
+        uint8_t* block = (uint8_t*)p;
+        oldBytes = AlignUp(oldBytes, Alignment);
+    #if TEMP_DEBUG
+        if(p)
+        {
+            Check(p);
+            // growing in place would run past the scope's mark and moving
+            // would land inside the scope; either way it's rewound with it
+            Assert(AlignUp(newBytes, Alignment) <= oldBytes || !m_scopeCount ||
+                (size_t)(block - m_buffer) >= m_scopes[m_scopeCount - 1]);
+        }
+    #endif // TEMP_DEBUG
+        // the last block handed out can simply move the head
+        if(block >= m_buffer && block + oldBytes == m_buffer + m_head)
+        {
+            size_t head = (size_t)(block - m_buffer) + AlignUp(newBytes, Alignment);
+        #if TEMP_DEBUG
+            Poison(head, m_head);
+            ((Header*)p - 1)->bytes = newBytes;
+        #endif // TEMP_DEBUG
+            SetHead(head);
+            return p;
+        }
+        // anywhere else, shrinking keeps the block where it is
+        if(block && AlignUp(newBytes, Alignment) <= oldBytes)
+        {
+        #if TEMP_DEBUG
+            const size_t start = (size_t)(block - m_buffer);
+            Poison(start + AlignUp(newBytes, Alignment), start + oldBytes);
+            ((Header*)p - 1)->bytes = newBytes;
+        #endif // TEMP_DEBUG
+            return p;
+        }
+        void* q = Alloc(newBytes);
+        if(p)
+        {
+            memcpy(q, p, Min(oldBytes, newBytes));
+        #if TEMP_DEBUG
+            ((Header*)p - 1)->magic = 0;
+            memset(p, PoisonByte, oldBytes);
+        #endif // TEMP_DEBUG
+        }
+        return q;
+    }
+    inline size_t Mark()
+    {
+    #if TEMP_DEBUG
+        Assert(m_scopeCount < MaxScopes);
+        m_scopes[m_scopeCount++] = m_head;
+    #endif // TEMP_DEBUG
+        return m_head;
+    }
+    inline void Rewind(size_t mark)
+    {
+        // scopes must unwind in reverse order of creation
+        Assert(mark >= m_frameBase && mark <= m_head);
+    #if TEMP_DEBUG
+        Assert(m_scopeCount > 0 && m_scopes[m_scopeCount - 1] == mark);
+        --m_scopeCount;
+        Poison(mark, m_head);
+    #endif // TEMP_DEBUG
+        m_head = mark;
     }
     inline void Update() 
     {
+        ++m_frame;
+    #if TEMP_DEBUG == 2
+        // recommitted on demand from the new base; wraps to the start once
+        // the rest of the range can't hold another frame of the same size
+        const size_t used = m_committed - m_frameBase;
+        VirtualMemory::Decommit(m_buffer + m_frameBase, used);
+        m_frameBase = m_committed + m_step;
+        if(m_frameBase + used + m_step > m_size)
+        {
+            m_frameBase = 0;
+        }
+        m_committed = m_frameBase;
+        m_head = m_frameBase;
+        m_framePeak = m_frameBase;
+        return;
+    #elif TEMP_DEBUG
+        Poison(0, m_framePeak);
+    #endif // TEMP_DEBUG
         m_head = 0;
+        if(m_decommitFrames > 0)
+        {
+            size_t used = AlignUp(m_framePeak, m_step);
+            if(used < m_committed)
+            {
+                m_quietPeak = Max(m_quietPeak, used);
+                if(++m_quietFrames >= m_decommitFrames)
+                {
+                    VirtualMemory::Decommit(m_buffer + m_quietPeak, m_committed - m_quietPeak);
+                    m_committed = m_quietPeak;
+                    m_quietFrames = 0;
+                    m_quietPeak = 0;
+                }
+            }
+            else
+            {
+                m_quietFrames = 0;
+                m_quietPeak = 0;
+            }
+        }
+        m_framePeak = 0;
     }
 };
 
@@ -60,28 +292,715 @@ struct DefaultAllocator : public BaseAllocator
     {
         free(p);
     }
+    // large blocks are mmap backed in glibc, where realloc becomes mremap
+    inline void* Realloc(void* p, size_t oldBytes, size_t newBytes) final
+    {
+        return realloc(p, newBytes);
+    }
+    inline void* AllocAligned(size_t bytes, size_t align) final
+    {
+        // mixing aligned_alloc with free() isn't portable; use AB_Slab instead
+        Assert(align <= 16);
+        return malloc(bytes);
+    }
+};
+
+// each thread bumps its own temp arena, so AB_Temp needs no locking.
+// the main thread owns the large arena, workers get a smaller one on first use.
+struct TempAllocator : public BaseAllocator
+{
+    static constexpr size_t MainArenaSize   = 1ul << 30ul;
+    static constexpr size_t WorkerArenaSize = 1ul << 28ul;
+    // frames of lower usage before an arena releases its committed tail, 0 keeps it
+    static constexpr int32_t DecommitFrames = 120;
+    static constexpr bool    HugePages      = false;
+
+    LinearAllocator         m_main;
+    std::thread::id         m_mainThread;
+    Array<LinearAllocator*> m_workers;
+    std::mutex              m_lock;
+
+    static thread_local LinearAllocator* ts_arena;
+
+    inline TempAllocator() : m_main(MainArenaSize, DecommitFrames, HugePages)
+    {
+        // static init runs on the main thread
+        m_mainThread = std::this_thread::get_id();
+    }
+    ~TempAllocator() final
+    {
+        for(LinearAllocator* arena : m_workers)
+        {
+            arena->~LinearAllocator();
+            free(arena);
+        }
+    }
+    LinearAllocator* CreateArena()
+    {
+        if(std::this_thread::get_id() == m_mainThread)
+        {
+            return &m_main;
+        }
+        LinearAllocator* arena = (LinearAllocator*)malloc(sizeof(LinearAllocator));
+        Assert(arena);
+        new (arena) LinearAllocator(WorkerArenaSize, DecommitFrames, HugePages);
+        // keep frame tags in step with the other arenas
+        arena->m_frame = m_main.m_frame;
+
+        LockGuard guard(m_lock);
+        m_workers.grow() = arena;
+        return arena;
+    }
+    inline LinearAllocator* GetArena()
+    {
+        if(!ts_arena)
+        {
+            ts_arena = CreateArena();
+        }
+        return ts_arena;
+    }
+    inline void* Alloc(size_t bytes) final
+    {
+        return GetArena()->Alloc(bytes);
+    }
+    inline void* Realloc(void* p, size_t oldBytes, size_t newBytes) final
+    {
+        return GetArena()->Realloc(p, oldBytes, newBytes);
+    }
+    inline void* AllocAligned(size_t bytes, size_t align) final
+    {
+        return GetArena()->AllocAligned(bytes, align);
+    }
+    inline size_t GetMark()
+    {
+        return GetArena()->Mark();
+    }
+    inline void Rewind(size_t mark)
+    {
+        GetArena()->Rewind(mark);
+    }
+    inline void Free(void* p) final
+    {
+    #if TEMP_DEBUG
+        // blocks may be freed on a thread other than the one that made them
+        if(!p)
+        {
+            return;
+        }
+        if(m_main.Owns(p))
+        {
+            m_main.Free(p);
+            return;
+        }
+        LockGuard guard(m_lock);
+        for(LinearAllocator* arena : m_workers)
+        {
+            if(arena->Owns(p))
+            {
+                arena->Free(p);
+                return;
+            }
+        }
+        Assert(false);
+    #endif // TEMP_DEBUG
+    }
+    // only call at the frame boundary, while no worker is running tasks.
+    // returns the combined peak of all arenas over the frame.
+    inline size_t Update()
+    {
+        size_t peak = m_main.FramePeak();
+        m_main.Update();
+        LockGuard guard(m_lock);
+        for(LinearAllocator* arena : m_workers)
+        {
+            peak += arena->FramePeak();
+            arena->Update();
+        }
+        return peak;
+    }
 };
 
+thread_local LinearAllocator* TempAllocator::ts_arena = nullptr;
+
+// two arenas used on alternate frames. a block stays valid through the end of
+// the frame after the one it was allocated in, so update can hand results to
+// a draw stage running a frame behind. shared by all threads under one lock.
+struct FrameAllocator : public BaseAllocator
+{
+    static constexpr size_t  ArenaSize      = 1ul << 28ul;
+    static constexpr int32_t DecommitFrames = 120;
+
+    LinearAllocator m_arenas[2];
+    int32_t         m_current;
+    std::mutex      m_lock;
+
+    inline FrameAllocator() : m_arenas{ {ArenaSize, DecommitFrames}, {ArenaSize, DecommitFrames} }
+    {
+        m_current = 0;
+    }
+    inline void* Alloc(size_t bytes) final
+    {
+        LockGuard guard(m_lock);
+        return m_arenas[m_current].Alloc(bytes);
+    }
+    inline void* Realloc(void* p, size_t oldBytes, size_t newBytes) final
+    {
+        LockGuard guard(m_lock);
+        return m_arenas[m_current].Realloc(p, oldBytes, newBytes);
+    }
+    inline void* AllocAligned(size_t bytes, size_t align) final
+    {
+        LockGuard guard(m_lock);
+        return m_arenas[m_current].AllocAligned(bytes, align);
+    }
+    inline void Free(void* p) final
+    {
+    #if TEMP_DEBUG
+        if(p)
+        {
+            LockGuard guard(m_lock);
+            m_arenas[m_arenas[1].Owns(p) ? 1 : 0].Free(p);
+        }
+    #endif // TEMP_DEBUG
+    }
+    // only call at the frame boundary. recycles the arena from two frames ago
+    // and returns the peak of the frame that just ended.
+    inline size_t Update()
+    {
+        LockGuard guard(m_lock);
+        size_t peak = m_arenas[m_current].FramePeak();
+        m_current ^= 1;
+        m_arenas[m_current].Update();
+        return peak;
+    }
+};
+
+// small blocks come from 64 KiB chunks carved out of one reserved range, each
+// chunk holding a single size class. threads keep a free list per class and
+// trade blocks with a shared list in batches, so the common path takes no lock.
+// chunks are never handed back to the OS.
+struct SlabAllocator : public BaseAllocator
+{
+    static constexpr size_t  RegionSize     = 1ull << 34ull;
+    static constexpr size_t  ChunkSize      = 1ul << 16ul;
+    static constexpr size_t  MaxSize        = 1ul << 15ul;
+    static constexpr size_t  LargeAlignment = 64;
+    static constexpr int32_t NumClasses     = 40;
+    static constexpr int32_t BatchSize      = 32;
+
+    struct Node
+    {
+        Node* next;
+    };
+    struct Cache
+    {
+        Node*   heads[NumClasses];
+        int32_t counts[NumClasses];
+    };
+
+    uint8_t*    m_base;
+    size_t      m_chunkCount;
+    Node*       m_shared[NumClasses];
+    std::mutex  m_lock;
+    uint8_t     m_classOf[MaxSize / 16 + 1];
+    uint8_t     m_chunkClass[RegionSize / ChunkSize];
+
+    static thread_local Cache ts_cache;
+
+    // 16 byte steps up to 128, then 4 classes per power of two up to MaxSize
+    static inline size_t ClassSize(int32_t c)
+    {
+        if(c < 8)
+        {
+            return (size_t)(c + 1) << 4;
+        }
+        const int32_t p = 7 + (c - 8) / 4;
+        const int32_t sub = (c - 8) & 3;
+        return (size_t)(5 + sub) << (p - 2);
+    }
+    static inline void* LargeAlloc(size_t bytes)
+    {
+    #ifdef _WIN32
+        return _aligned_malloc(bytes, LargeAlignment);
+    #else
+        void* p = nullptr;
+        posix_memalign(&p, LargeAlignment, bytes);
+        return p;
+    #endif // _WIN32
+    }
+    static inline void LargeFree(void* p)
+    {
+    #ifdef _WIN32
+        _aligned_free(p);
+    #else
+        free(p);
+    #endif // _WIN32
+    }
+
+    inline SlabAllocator()
+    {
+        m_base = (uint8_t*)VirtualMemory::Reserve(RegionSize);
+        // page aligned in practice; AllocAligned relies on at least this
+        Assert(((uintptr_t)m_base & (LargeAlignment - 1u)) == 0);
+        m_chunkCount = 0;
+        MemZero(m_shared);
+        int32_t c = 0;
+        for(size_t i = 0; i < NELEM(m_classOf); ++i)
+        {
+            while(ClassSize(c) < i * 16)
+            {
+                ++c;
+            }
+            m_classOf[i] = (uint8_t)c;
+        }
+    }
+    ~SlabAllocator() final
+    {
+        VirtualMemory::Release(m_base, RegionSize);
+    }
+    inline bool Owns(const void* p) const
+    {
+        return (const uint8_t*)p >= m_base && (const uint8_t*)p < m_base + RegionSize;
+    }
+    inline int32_t ClassOf(const void* p) const
+    {
+        return m_chunkClass[((const uint8_t*)p - m_base) / ChunkSize];
+    }
+    // pulls a batch into the calling thread's cache, carving a chunk if needed
+    void Refill(int32_t c)
+    {
+        Cache& cache = ts_cache;
+        LockGuard guard(m_lock);
+        if(m_shared[c])
+        {
+            for(int32_t i = 0; i < BatchSize && m_shared[c]; ++i)
+            {
+                Node* node = m_shared[c];
+                m_shared[c] = node->next;
+                node->next = cache.heads[c];
+                cache.heads[c] = node;
+                ++cache.counts[c];
+            }
+            return;
+        }
+
+        Assert((m_chunkCount + 1) * ChunkSize <= RegionSize);
+        uint8_t* chunk = m_base + m_chunkCount * ChunkSize;
+        m_chunkClass[m_chunkCount] = (uint8_t)c;
+        ++m_chunkCount;
+        VirtualMemory::Commit(chunk, ChunkSize);
+
+        const size_t size = ClassSize(c);
+        for(size_t offset = (ChunkSize / size - 1) * size; ; offset -= size)
+        {
+            Node* node = (Node*)(chunk + offset);
+            node->next = cache.heads[c];
+            cache.heads[c] = node;
+            ++cache.counts[c];
+            if(offset == 0)
+            {
+                break;
+            }
+        }
+    }
+    // hands a batch back once a thread is holding too many free blocks
+    void Drain(int32_t c)
+    {
+        Cache& cache = ts_cache;
+        LockGuard guard(m_lock);
+        for(int32_t i = 0; i < BatchSize; ++i)
+        {
+            Node* node = cache.heads[c];
+            cache.heads[c] = node->next;
+            --cache.counts[c];
+            node->next = m_shared[c];
+            m_shared[c] = node;
+        }
+    }
+    inline void* AllocClass(int32_t c)
+    {
+        Cache& cache = ts_cache;
+        if(!cache.heads[c])
+        {
+            Refill(c);
+        }
+        Node* node = cache.heads[c];
+        cache.heads[c] = node->next;
+        --cache.counts[c];
+        return node;
+    }
+    inline void* Alloc(size_t bytes) final
+    {
+        if(bytes > MaxSize)
+        {
+            return LargeAlloc(bytes);
+        }
+        return AllocClass(m_classOf[(bytes + 15) >> 4]);
+    }
+    inline void* AllocAligned(size_t bytes, size_t align) final
+    {
+        Assert(align <= LargeAlignment);
+        if(bytes <= MaxSize)
+        {
+            // chunks start on page boundaries, so a class size that is a
+            // multiple of align puts every block on an aligned address
+            for(int32_t c = m_classOf[(bytes + 15) >> 4]; c < NumClasses; ++c)
+            {
+                if((ClassSize(c) & (align - 1u)) == 0)
+                {
+                    return AllocClass(c);
+                }
+            }
+        }
+        return LargeAlloc(bytes);
+    }
+    inline void Free(void* p) final
+    {
+        if(!Owns(p))
+        {
+            LargeFree(p);
+            return;
+        }
+        const int32_t c = ClassOf(p);
+        Cache& cache = ts_cache;
+        Node* node = (Node*)p;
+        node->next = cache.heads[c];
+        cache.heads[c] = node;
+        if(++cache.counts[c] > BatchSize * 2)
+        {
+            Drain(c);
+        }
+    }
+    inline void* Realloc(void* p, size_t oldBytes, size_t newBytes) final
+    {
+        if(Owns(p) && newBytes <= ClassSize(ClassOf(p)))
+        {
+            return p;
+        }
+        // keep the alignment p had, up to LargeAlignment, so a block from
+        // AllocAligned stays aligned when it moves
+        size_t align = 16;
+        if(p)
+        {
+            const uintptr_t addr = (uintptr_t)p;
+            align = Min(Max((size_t)(addr & (0u - addr)), (size_t)16), LargeAlignment);
+        }
+        void* q = AllocAligned(newBytes, align);
+        if(p)
+        {
+            memcpy(q, p, Min(oldBytes, newBytes));
+            Free(p);
+        }
+        return q;
+    }
+};
+
+thread_local SlabAllocator::Cache SlabAllocator::ts_cache;
+
 DefaultAllocator    ms_default;
-LinearAllocator     ms_temp(1ul << 30ul);
+TempAllocator       ms_temp;
+SlabAllocator       ms_slab;
+FrameAllocator      ms_frame;
 BaseAllocator*      ms_allocators[] = 
 {
     &ms_default,
     &ms_temp,
+    &ms_slab,
+    &ms_frame,
 };
 
+#if ALLOC_TELEMETRY
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+    #define CallerAddress() _ReturnAddress()
+#else
+    #define CallerAddress() __builtin_return_address(0)
+#endif // _MSC_VER
+
+#include <atomic>
+
+// counts the current frame; Update() snapshots it and starts over
+struct Telemetry
+{
+    static constexpr int32_t SiteCapacity = 1024;
+    static constexpr int32_t TopCount     = 32;
+    static constexpr int32_t MaxTables    = 64;
+
+    // one per thread, so recording never contends with other threads. the
+    // lock is only taken by someone else while Update() merges the table.
+    struct SiteTable
+    {
+        std::mutex              m_lock;
+        uint64_t                m_allocs[AB_Count];
+        uint64_t                m_frees[AB_Count];
+        uint64_t                m_bytes[AB_Count];
+        AllocSite               m_sites[SiteCapacity];
+    };
+
+    // tables come from malloc, as the allocator can't record its own use.
+    // they outlive their threads; threads past MaxTables share m_overflow.
+    std::atomic<SiteTable*>     m_tables[MaxTables];
+    std::atomic<int32_t>        m_tableCount;
+    SiteTable                   m_overflow;
+    // merged sites of the frame, only touched by Update()
+    AllocSite                   m_merged[SiteCapacity];
+    FixedArray<AllocSite, TopCount> m_top;
+
+    static thread_local const char* ts_tag;
+    static thread_local SiteTable*  ts_table;
+
+    inline SiteTable& GetTable()
+    {
+        if(!ts_table)
+        {
+            const int32_t slot = m_tableCount.fetch_add(1, std::memory_order_relaxed);
+            if(slot < MaxTables)
+            {
+                SiteTable* table = (SiteTable*)calloc(1, sizeof(SiteTable));
+                new (&table->m_lock) std::mutex();
+                m_tables[slot].store(table, std::memory_order_release);
+                ts_table = table;
+            }
+            else
+            {
+                ts_table = &m_overflow;
+            }
+        }
+        return *ts_table;
+    }
+    static inline void AddSite(AllocSite* sites, const void* key, const char* tag, uint64_t bytes, uint64_t count)
+    {
+        uint64_t h = (uint64_t)(uintptr_t)key;
+        h ^= h >> 17;
+        h *= 0xed5ad4bbull;
+        for(int32_t i = 0; i < SiteCapacity; ++i)
+        {
+            AllocSite& site = sites[(h + i) & (SiteCapacity - 1)];
+            if(!site.count || site.address == key)
+            {
+                site.address = key;
+                site.tag = tag;
+                site.bytes += bytes;
+                site.count += count;
+                return;
+            }
+        }
+    }
+    inline void OnAlloc(AllocBucket bucket, size_t bytes, const void* address)
+    {
+        const char* tag = ts_tag;
+        SiteTable& table = GetTable();
+        LockGuard guard(table.m_lock);
+        table.m_allocs[bucket] += 1;
+        table.m_bytes[bucket] += bytes;
+        AddSite(table.m_sites, tag ? (const void*)tag : address, tag, bytes, 1);
+    }
+    inline void OnFree(AllocBucket bucket, void* p)
+    {
+        if(p)
+        {
+            SiteTable& table = GetTable();
+            LockGuard guard(table.m_lock);
+            table.m_frees[bucket] += 1;
+        }
+    }
+    void Merge(SiteTable& table, AllocStats& stats)
+    {
+        LockGuard guard(table.m_lock);
+        for(int32_t i = 0; i < AB_Count; ++i)
+        {
+            stats.allocs[i] += table.m_allocs[i];
+            stats.frees[i] += table.m_frees[i];
+            stats.bytes[i] += table.m_bytes[i];
+        }
+        for(const AllocSite& site : table.m_sites)
+        {
+            if(site.count)
+            {
+                AddSite(m_merged, site.address, site.tag, site.bytes, site.count);
+            }
+        }
+        MemZero(table.m_allocs);
+        MemZero(table.m_frees);
+        MemZero(table.m_bytes);
+        MemZero(table.m_sites);
+    }
+    void Update(AllocStats& stats)
+    {
+        MemZero(stats.allocs);
+        MemZero(stats.frees);
+        MemZero(stats.bytes);
+        MemZero(m_merged);
+        const int32_t count = Min(m_tableCount.load(std::memory_order_relaxed), MaxTables);
+        for(int32_t i = 0; i < count; ++i)
+        {
+            // a thread that just took a slot may not have published its table
+            if(SiteTable* table = m_tables[i].load(std::memory_order_acquire))
+            {
+                Merge(*table, stats);
+            }
+        }
+        Merge(m_overflow, stats);
+
+        m_top.clear();
+        for(const AllocSite& site : m_merged)
+        {
+            if(!site.count)
+            {
+                continue;
+            }
+            if(m_top.full())
+            {
+                if(site.bytes <= m_top.back().bytes)
+                {
+                    continue;
+                }
+                m_top.pop();
+            }
+            // insertion keeps m_top sorted by descending bytes
+            int32_t i = m_top.count();
+            m_top.append() = site;
+            for(; i > 0 && m_top[i - 1].bytes < site.bytes; --i)
+            {
+                m_top[i] = m_top[i - 1];
+            }
+            m_top[i] = site;
+        }
+    }
+};
+
+thread_local const char* Telemetry::ts_tag = nullptr;
+thread_local Telemetry::SiteTable* Telemetry::ts_table = nullptr;
+
+Telemetry           ms_telemetry;
+
+#endif // ALLOC_TELEMETRY
+
+AllocStats          ms_stats;
+
 namespace Allocator
 {
     void* Alloc(AllocBucket bucket, size_t bytes)
     {
+    #if ALLOC_TELEMETRY
+        ms_telemetry.OnAlloc(bucket, bytes, CallerAddress());
+    #endif // ALLOC_TELEMETRY
         return ms_allocators[bucket]->Alloc(bytes);
     }
     void Free(AllocBucket bucket, void* p)
     {
+    #if ALLOC_TELEMETRY
+        ms_telemetry.OnFree(bucket, p);
+    #endif // ALLOC_TELEMETRY
         return ms_allocators[bucket]->Free(p);
     }
+    void* Realloc(AllocBucket bucket, void* p, size_t oldBytes, size_t newBytes)
+    {
+    #if ALLOC_TELEMETRY
+        ms_telemetry.OnAlloc(bucket, newBytes > oldBytes ? newBytes - oldBytes : 0, CallerAddress());
+    #endif // ALLOC_TELEMETRY
+        return ms_allocators[bucket]->Realloc(p, oldBytes, newBytes);
+    }
+    void* AllocAligned(AllocBucket bucket, size_t bytes, size_t align)
+    {
+    #if ALLOC_TELEMETRY
+        ms_telemetry.OnAlloc(bucket, bytes, CallerAddress());
+    #endif // ALLOC_TELEMETRY
+        return ms_allocators[bucket]->AllocAligned(bytes, align);
+    }
     void Update()
     {
-        ms_temp.Update();
+        ms_stats.tempPeak = ms_temp.Update();
+        ms_stats.tempHighWater = Max(ms_stats.tempHighWater, ms_stats.tempPeak);
+        ms_stats.framePeak = ms_frame.Update();
+    #if ALLOC_TELEMETRY
+        ms_telemetry.Update(ms_stats);
+    #endif // ALLOC_TELEMETRY
+    }
+    size_t GetTempMark()
+    {
+        return ms_temp.GetMark();
+    }
+    void RewindTemp(size_t mark)
+    {
+        ms_temp.Rewind(mark);
+    }
+    const char* GetBucketName(AllocBucket bucket)
+    {
+        static const char* names[] = 
+        {
+            "Default",
+            "Temp",
+            "Slab",
+            "Frame",
+        };
+        static_assert(NELEM(names) == AB_Count, "missing bucket name");
+        return names[bucket];
+    }
+    const AllocStats& GetFrameStats()
+    {
+        return ms_stats;
+    }
+    int32_t GetTopSites(AllocSite* sites, int32_t capacity)
+    {
+    #if ALLOC_TELEMETRY
+        int32_t count = Min(capacity, ms_telemetry.m_top.count());
+        Copy(sites, ms_telemetry.m_top.begin(), count);
+        return count;
+    #else
+        return 0;
+    #endif // ALLOC_TELEMETRY
+    }
+    bool DumpStats(const char* path)
+    {
+        FILE* file = fopen(path, "w");
+        if(!file)
+        {
+            return false;
+        }
+        const AllocStats& stats = ms_stats;
+        fprintf(file, "bucket, allocs, frees, bytes\n");
+        for(int32_t i = 0; i < AB_Count; ++i)
+        {
+            fprintf(file, "%s, %llu, %llu, %llu\n",
+                GetBucketName((AllocBucket)i),
+                (unsigned long long)stats.allocs[i],
+                (unsigned long long)stats.frees[i],
+                (unsigned long long)stats.bytes[i]);
+        }
+        fprintf(file, "temp peak, %llu\n", (unsigned long long)stats.tempPeak);
+        fprintf(file, "temp high water, %llu\n", (unsigned long long)stats.tempHighWater);
+        fprintf(file, "frame peak, %llu\n", (unsigned long long)stats.framePeak);
+
+        AllocSite sites[64];
+        int32_t count = GetTopSites(sites, NELEM(sites));
+        fprintf(file, "site, bytes, count\n");
+        for(int32_t i = 0; i < count; ++i)
+        {
+            if(sites[i].tag)
+            {
+                fprintf(file, "%s, ", sites[i].tag);
+            }
+            else
+            {
+                fprintf(file, "%p, ", sites[i].address);
+            }
+            fprintf(file, "%llu, %llu\n",
+                (unsigned long long)sites[i].bytes,
+                (unsigned long long)sites[i].count);
+        }
+        fclose(file);
+        return true;
+    }
+    const char* SetTag(const char* tag)
+    {
+    #if ALLOC_TELEMETRY
+        const char* prev = Telemetry::ts_tag;
+        Telemetry::ts_tag = tag;
+        return prev;
+    #else
+        return nullptr;
+    #endif // ALLOC_TELEMETRY
     }
 };
@@ -1,20 +1,70 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <new>
 
 enum AllocBucket
 {
     AB_Default = 0,
     AB_Temp,
+    AB_Slab,
+    // valid until the end of the next frame, see Allocator::Update
+    AB_Frame,
+    AB_Count
+};
+
+// per bucket counters for one frame. bucket counters are only gathered
+// with ALLOC_TELEMETRY, the temp and frame arena peaks are always tracked.
+struct AllocStats
+{
+    uint64_t allocs[AB_Count];
+    uint64_t frees[AB_Count];
+    uint64_t bytes[AB_Count];
+    uint64_t tempPeak;
+    uint64_t tempHighWater;
+    uint64_t framePeak;
+};
+
+// an allocating call site, keyed by its AllocTag or return address. the
+// return address is the function that called into Allocator, which for
+// container growth (Array, HashMap, New<T>, ...) is the container's own
+// code rather than its user; wrap code worth attributing in an AllocTag.
+struct AllocSite
+{
+    const void* address;
+    const char* tag;
+    uint64_t    bytes;
+    uint64_t    count;
 };
 
 namespace Allocator
 {
     void* Alloc(AllocBucket bucket, size_t bytes);
     void Free(AllocBucket bucket, void* p);
+    // grows or shrinks a block, preserving the first min(oldBytes, newBytes) bytes.
+    // extends in place when possible, otherwise moves the block.
+    void* Realloc(AllocBucket bucket, void* p, size_t oldBytes, size_t newBytes);
+    // align must be a power of two. AB_Slab, AB_Temp and AB_Frame support up to 64,
+    // AB_Default only guarantees malloc's 16. free with Free() as usual.
+    void* AllocAligned(AllocBucket bucket, size_t bytes, size_t align);
+    // call once per frame: resets AB_Temp and the older half of AB_Frame
     void Update();
 
+    const char* GetBucketName(AllocBucket bucket);
+    // stats of the last completed frame
+    const AllocStats& GetFrameStats();
+    // heaviest call sites of the last completed frame, by bytes
+    int32_t GetTopSites(AllocSite* sites, int32_t capacity);
+    bool DumpStats(const char* path);
+    // names allocations made by the calling thread, nullptr for return addresses
+    const char* SetTag(const char* tag);
+
+    // position of the calling thread's temp arena, for TempScope. under
+    // TEMP_DEBUG this opens a scope, so pair every call with one RewindTemp
+    size_t GetTempMark();
+    void RewindTemp(size_t mark);
+
     template<typename T>
     T* Alloc(AllocBucket bucket)
     {
@@ -37,3 +87,40 @@ namespace Allocator
         }
     }
 };
+
+// rolls the calling thread's temp arena back to where it was on construction.
+// nests; anything allocated from AB_Temp inside the scope is invalid afterwards.
+// temp blocks allocated before the scope must not grow inside it: the last one
+// would grow in place past the mark and be overlapped once the scope rewinds.
+// TEMP_DEBUG traps on that.
+struct TempScope
+{
+    size_t m_mark;
+
+    inline TempScope()
+    {
+        m_mark = Allocator::GetTempMark();
+    }
+    inline ~TempScope()
+    {
+        Allocator::RewindTemp(m_mark);
+    }
+    TempScope(const TempScope&) = delete;
+    TempScope& operator=(const TempScope&) = delete;
+};
+
+struct AllocTag
+{
+    const char* m_prev;
+
+    inline AllocTag(const char* tag)
+    {
+        m_prev = Allocator::SetTag(tag);
+    }
+    inline ~AllocTag()
+    {
+        Allocator::SetTag(m_prev);
+    }
+    AllocTag(const AllocTag&) = delete;
+    AllocTag& operator=(const AllocTag&) = delete;
+};
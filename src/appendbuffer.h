@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#include "macro.h"
+#include "array.h"
+#include "sema.h"
+
+// output sink for parallel jobs. writes go straight into the reserved
+// storage of a target Array, claiming ranges with a single fetch-add, so
+// Finish() hands the results over without copying. once the reservation is
+// used up, appends fall back to a locked overflow array that Finish()
+// copies onto the end; size the reservation for the common case.
+// results land in claim order, which is arbitrary across threads.
+template<typename T, bool POD, AllocBucket t_bucket>
+struct AppendBuffer
+{
+    static_assert(TriviallyRelocatable<T>::value, "AppendBuffer copies items with memcpy");
+
+    Array<T, POD, t_bucket>*    m_target;
+    T*                          m_data;
+    int32_t                     m_capacity;
+    std::atomic<int32_t>        m_head;
+    // start of the one claim that ran past m_capacity, if any
+    std::atomic<int32_t>        m_cut;
+
+    std::mutex                  m_overflowLock;
+    Array<T, true, AB_Default>  m_overflow;
+
+    // clears target and reserves capacity items in it
+    inline AppendBuffer(Array<T, POD, t_bucket>& target, int32_t capacity)
+    {
+        target.clear();
+        target.reserve(capacity);
+        m_target = &target;
+        m_data = target.begin();
+        m_capacity = target.capacity();
+        m_head.store(0, std::memory_order_relaxed);
+        m_cut.store(-1, std::memory_order_relaxed);
+    }
+    AppendBuffer(const AppendBuffer&) = delete;
+    AppendBuffer& operator=(const AppendBuffer&) = delete;
+
+    // safe to call from any number of threads until Finish
+    inline void Append(const T* items, int32_t count)
+    {
+        const int32_t begin = m_head.fetch_add(count, std::memory_order_relaxed);
+        const int32_t end = begin + count;
+        if(end <= m_capacity)
+        {
+            memcpy(m_data + begin, items, sizeof(T) * count);
+            return;
+        }
+        if(begin < m_capacity)
+        {
+            m_cut.store(begin, std::memory_order_relaxed);
+        }
+        LockGuard guard(m_overflowLock);
+        const int32_t at = m_overflow.count();
+        m_overflow.resize(at + count);
+        memcpy(m_overflow.begin() + at, items, sizeof(T) * count);
+    }
+    inline void Append(const T& item)
+    {
+        Append(&item, 1);
+    }
+
+    // call once every producer is done; returns the item count
+    inline int32_t Finish()
+    {
+        const int32_t cut = m_cut.load(std::memory_order_relaxed);
+        const int32_t reserved = cut != -1 ? cut : Min(m_head.load(std::memory_order_relaxed), m_capacity);
+        m_target->m_count = reserved;
+        if(!m_overflow.empty())
+        {
+            m_target->reserve(reserved + m_overflow.count());
+            memcpy(m_target->begin() + reserved, m_overflow.begin(), m_overflow.bytes());
+            m_target->m_count = reserved + m_overflow.count();
+            m_overflow.reset();
+        }
+        return m_target->count();
+    }
+};
@@ -0,0 +1,123 @@
+#include "archetype.h"
+
+void Archetype::Init(ComponentMask mask, const uint32_t* sizes)
+{
+    m_mask = mask;
+    m_count = 0;
+    new (&m_chunks) Array<uint8_t*>();
+
+    size_t rowBytes = sizeof(slot);
+    int32_t columns = 1;
+    for(int32_t t = 0; t < CT_Count; ++t)
+    {
+        m_add[t] = -1;
+        m_remove[t] = -1;
+        m_offsets[t] = 0u;
+        m_sizes[t] = (mask & MaskOf((ComponentType)t)) ? sizes[t] : 0u;
+        if(m_sizes[t])
+        {
+            rowBytes += m_sizes[t];
+            ++columns;
+        }
+    }
+
+    // worst case padding of each column start
+    m_chunkRows = (int32_t)((ChunkBytes - columns * ColumnAlign) / rowBytes);
+    Assert(m_chunkRows > 0);
+
+    size_t offset = sizeof(slot) * m_chunkRows;
+    for(int32_t t = 0; t < CT_Count; ++t)
+    {
+        if(m_sizes[t])
+        {
+            offset = (offset + ColumnAlign - 1) & ~(ColumnAlign - 1);
+            m_offsets[t] = (uint32_t)offset;
+            offset += (size_t)m_sizes[t] * m_chunkRows;
+        }
+    }
+    Assert(offset <= ChunkBytes);
+}
+
+void Archetype::Reset()
+{
+    for(uint8_t* chunk : m_chunks)
+    {
+        Allocator::Free(AB_Slab, chunk);
+    }
+    m_chunks.reset();
+    m_count = 0;
+}
+
+int32_t Archetype::AddRow(slot s)
+{
+    const int32_t row = m_count++;
+    const int32_t chunk = row / m_chunkRows;
+    if(chunk == m_chunks.count())
+    {
+        m_chunks.grow() = (uint8_t*)Allocator::AllocAligned(AB_Slab, ChunkBytes, 64);
+    }
+    SlotOf(row) = s;
+    for(int32_t t = 0; t < CT_Count; ++t)
+    {
+        if(m_sizes[t])
+        {
+            memset(Get((ComponentType)t, row), 0, m_sizes[t]);
+        }
+    }
+    return row;
+}
+
+int32_t Archetype::AddRows(const slot* slots, int32_t count)
+{
+    const int32_t first = m_count;
+    m_count += count;
+    const int32_t chunks = ChunkCount();
+    m_chunks.reserve(chunks);
+    while(m_chunks.count() < chunks)
+    {
+        m_chunks.grow() = (uint8_t*)Allocator::AllocAligned(AB_Slab, ChunkBytes, 64);
+    }
+    // fill one chunk span at a time
+    int32_t row = first;
+    while(row < m_count)
+    {
+        const int32_t chunk = row / m_chunkRows;
+        const int32_t idx = row - chunk * m_chunkRows;
+        const int32_t n = Min(m_count - row, m_chunkRows - idx);
+        memcpy(Slots(chunk) + idx, slots + (row - first), sizeof(slot) * n);
+        for(int32_t t = 0; t < CT_Count; ++t)
+        {
+            if(m_sizes[t])
+            {
+                memset(Get((ComponentType)t, row), 0, (size_t)m_sizes[t] * n);
+            }
+        }
+        row += n;
+    }
+    return first;
+}
+
+slot Archetype::RemoveRow(int32_t row)
+{
+    const int32_t last = --m_count;
+    slot moved;
+    if(row != last)
+    {
+        moved = SlotOf(last);
+        SlotOf(row) = moved;
+        for(int32_t t = 0; t < CT_Count; ++t)
+        {
+            if(m_sizes[t])
+            {
+                memcpy(Get((ComponentType)t, row), Get((ComponentType)t, last), m_sizes[t]);
+            }
+        }
+    }
+    // keep one spare chunk so an entity toggling at a boundary doesn't thrash
+    if(m_chunks.count() > 1 && (m_chunks.count() - 2) * m_chunkRows >= m_count)
+    {
+        Allocator::Free(AB_Slab, m_chunks.back());
+        m_chunks.pop();
+    }
+    return moved;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "macro.h"
+#include "slot.h"
+#include "component.h"
+#include "array.h"
+#include "allocator.h"
+
+// storage for every entity with one exact set of components. rows live in
+// fixed size chunks; each chunk holds a slot column followed by one column
+// per component type, so walking a type touches contiguous memory. rows stay
+// dense by moving the last row into any hole.
+struct Archetype
+{
+    static constexpr size_t  ChunkBytes     = 1ul << 14ul;
+    static constexpr size_t  ColumnAlign    = 16;
+
+    ComponentMask           m_mask;
+    int32_t                 m_chunkRows;
+    int32_t                 m_count;
+    // per type; offset of the column within a chunk and the item size.
+    // types without data (size 0) are tracked in the mask only.
+    uint32_t                m_offsets[CT_Count];
+    uint32_t                m_sizes[CT_Count];
+    // archetype index reached by adding or removing a type, -1 if not yet known
+    int32_t                 m_add[CT_Count];
+    int32_t                 m_remove[CT_Count];
+    Array<uint8_t*>         m_chunks;
+
+    void Init(ComponentMask mask, const uint32_t* sizes);
+    void Reset();
+    // appends a zeroed row for s, returning its index
+    int32_t AddRow(slot s);
+    // appends zeroed rows for count slots, returning the first index
+    int32_t AddRows(const slot* slots, int32_t count);
+    // fills the hole with the last row; returns the slot that moved into
+    // row, or an invalid slot if row was last
+    slot RemoveRow(int32_t row);
+
+    inline bool Has(ComponentType type) const
+    {
+        return (m_mask & MaskOf(type)) != 0u;
+    }
+    // chunks holding rows; a spare empty chunk may follow them
+    inline int32_t ChunkCount() const
+    {
+        return (m_count + m_chunkRows - 1) / m_chunkRows;
+    }
+    inline int32_t RowsInChunk(int32_t chunk) const
+    {
+        return Min(m_count - chunk * m_chunkRows, m_chunkRows);
+    }
+    inline slot* Slots(int32_t chunk) const
+    {
+        return (slot*)m_chunks[chunk];
+    }
+    // start of a type's column in a chunk, nullptr for types without data
+    inline void* Column(int32_t chunk, ComponentType type) const
+    {
+        if(!Has(type) || !m_sizes[type])
+        {
+            return nullptr;
+        }
+        return m_chunks[chunk] + m_offsets[type];
+    }
+    inline void* Get(ComponentType type, int32_t row) const
+    {
+        if(!Has(type) || !m_sizes[type])
+        {
+            return nullptr;
+        }
+        const int32_t chunk = row / m_chunkRows;
+        const int32_t idx = row - chunk * m_chunkRows;
+        return m_chunks[chunk] + m_offsets[type] + (size_t)idx * m_sizes[type];
+    }
+    inline slot& SlotOf(int32_t row) const
+    {
+        const int32_t chunk = row / m_chunkRows;
+        return Slots(chunk)[row - chunk * m_chunkRows];
+    }
+};
+
+TRIVIALLY_RELOCATABLE(Archetype)
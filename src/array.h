@@ -3,13 +3,37 @@
 #include <stdint.h>
 #include <string.h>
 #include <new>
+#include <utility>
+#include <type_traits>
 
 #include "macro.h"
 #include "allocator.h"
 
+// types that survive being memcpy'd to a new address without running the
+// move constructor and destructor. non-POD arrays of these grow with realloc.
+template<typename T>
+struct TriviallyRelocatable
+{
+    static constexpr bool value = std::is_trivially_copyable<T>::value;
+};
+
+#define TRIVIALLY_RELOCATABLE(T) \
+    template<> struct TriviallyRelocatable<T> { static constexpr bool value = true; };
+
 template<typename T, bool POD = true, AllocBucket t_bucket = AB_Default>
+struct Array;
+
+template<typename T, bool POD, AllocBucket t_bucket>
+struct TriviallyRelocatable<Array<T, POD, t_bucket>>
+{
+    static constexpr bool value = true;
+};
+
+template<typename T, bool POD, AllocBucket t_bucket>
 struct Array
 {
+    static constexpr bool Relocatable = POD || TriviallyRelocatable<T>::value;
+
     T*          m_data;
     int32_t     m_count;
     int32_t     m_capacity;
@@ -22,34 +46,12 @@ struct Array
     Array(const T* x, int32_t ct)
     {
         MemZero(*this);
-        resize(ct);
-        if(!POD)
-        {
-            for(int32_t i = 0; i < count(); ++i)
-            {
-                m_data[i] = x[i];
-            }
-        }
-        else
-        {
-            Copy(begin(), x, ct);
-        }
+        copyFrom(x, ct);
     }
     Array(const Array& other)
     {
         MemZero(*this);
-        resize(other.count());
-        if(POD)
-        {
-            Copy(begin(), other.begin(), count());
-        }
-        else
-        {
-            for(int32_t i = 0; i < count(); ++i)
-            {
-                m_data[i] = other[i];
-            }
-        }
+        copyFrom(other.begin(), other.count());
     }
     inline Array(Array&& other) noexcept
     {
@@ -57,18 +59,10 @@ struct Array
     }
     Array& operator=(const Array& other)
     {
-        reset();
-        resize(other.count());
-        if(POD)
+        if(this != &other)
         {
-            Copy(begin(), other.begin(), count());
-        }
-        else
-        {
-            for(int32_t i = 0; i < count(); ++i)
-            {
-                m_data[i] = other[i];
-            }
+            reset();
+            copyFrom(other.begin(), other.count());
         }
         return *this;
     }
@@ -100,13 +94,46 @@ struct Array
     {
         if(new_cap > capacity())
         {
-            T* data = (T*)Allocator::Alloc(t_bucket, sizeof(T) * new_cap);
-            Copy(data, begin(), count());
-            Allocator::Free(t_bucket, m_data);
-            m_data = data;
+            if(Relocatable)
+            {
+                m_data = (T*)Allocator::Realloc(
+                    t_bucket, 
+                    m_data, 
+                    sizeof(T) * capacity(), 
+                    sizeof(T) * new_cap);
+            }
+            else
+            {
+                T* data = (T*)Allocator::Alloc(t_bucket, sizeof(T) * new_cap);
+                for(int32_t i = 0; i < m_count; ++i)
+                {
+                    new (data + i) T(std::move(m_data[i]));
+                    (m_data + i)->~T();
+                }
+                Allocator::Free(t_bucket, m_data);
+                m_data = data;
+            }
             m_capacity = new_cap;
         }
     }
+    // copy constructs into an empty array
+    void copyFrom(const T* x, int32_t ct)
+    {
+        Assert(empty());
+        reserve(ct);
+        if(POD)
+        {
+            Copy(begin(), x, ct);
+        }
+        else
+        {
+            for(int32_t i = 0; i < ct; ++i)
+            {
+                new (m_data + i) T(x[i]);
+            }
+        }
+        m_count = ct;
+    }
     inline void expand(int32_t step)
     {
         int32_t newCount = count() + step;
@@ -157,6 +184,25 @@ struct Array
         }
         return back();
     }
+    template<typename... Args>
+    inline T& emplace(Args&&... args)
+    {
+        if(count() == capacity())
+        {
+            reserve(capacity() ? capacity() * 2 : 16);
+        }
+        new (m_data + m_count) T(std::forward<Args>(args)...);
+        ++m_count;
+        return back();
+    }
+    inline T& push(const T& t)
+    {
+        return emplace(t);
+    }
+    inline T& push(T&& t)
+    {
+        return emplace(std::move(t));
+    }
     inline void pop()
     {
         Assert(!empty());
@@ -185,14 +231,17 @@ struct Array
     }
     inline void remove(int32_t idx)
     {
-        m_data[idx] = back();
+        if(idx != count() - 1)
+        {
+            m_data[idx] = std::move(back());
+        }
         pop();
     }
     inline void shiftRemove(int32_t idx)
     {
         for(int32_t i = idx + 1; i < count(); ++i)
         {
-            m_data[i - 1] = m_data[i];
+            m_data[i - 1] = std::move(m_data[i]);
         }
         pop();
     }
@@ -211,7 +260,7 @@ struct Array
         if(idx == -1)
         {
             idx = count();
-            grow() = t;
+            push(t);
         }
         return idx;
     }
@@ -230,6 +279,269 @@ struct Array
 template<typename T, bool POD = true>
 using TempArray = Array<T, POD, AB_Temp>;
 
+template<typename T, bool POD = true>
+using FrameArray = Array<T, POD, AB_Frame>;
+
+// Array that keeps its first N elements inline and only takes memory from
+// t_bucket once it outgrows them. holds no pointer into itself, so it can
+// be memcpy'd like Array; elements must be POD or trivially relocatable.
+template<typename T, int32_t N, bool POD = true, AllocBucket t_bucket = AB_Default>
+struct SmallArray
+{
+    static_assert(POD || TriviallyRelocatable<T>::value, "SmallArray elements are moved with memcpy");
+
+    union
+    {
+        T*                      m_heap;
+        alignas(T) uint8_t      m_inline[sizeof(T) * N];
+    };
+    int32_t     m_count;
+    // 0 while inline
+    int32_t     m_capacity;
+
+    inline SmallArray()
+    {
+        MemZero(*this);
+    }
+    ~SmallArray() { reset(); }
+    SmallArray(const T* x, int32_t ct)
+    {
+        MemZero(*this);
+        copyFrom(x, ct);
+    }
+    SmallArray(const SmallArray& other)
+    {
+        MemZero(*this);
+        copyFrom(other.begin(), other.count());
+    }
+    inline SmallArray(SmallArray&& other) noexcept
+    {
+        Assume(*this, other);
+    }
+    SmallArray& operator=(const SmallArray& other)
+    {
+        if(this != &other)
+        {
+            reset();
+            copyFrom(other.begin(), other.count());
+        }
+        return *this;
+    }
+    inline SmallArray& operator=(SmallArray&& other) noexcept
+    {
+        reset();
+        Assume(*this, other);
+        return *this;
+    }
+    inline bool onHeap()        const { return m_capacity != 0; }
+    inline int32_t capacity()   const { return onHeap() ? m_capacity : N; }
+    inline int32_t count()      const { return m_count; }
+    inline bool full()          const { return count() == capacity(); }
+    inline bool empty()         const { return count() == 0; }
+    inline size_t bytes()       const { return sizeof(T) * (size_t)count(); }
+    inline T* begin()                 { return onHeap() ? m_heap : (T*)m_inline; }
+    inline const T* begin()     const { return onHeap() ? m_heap : (const T*)m_inline; }
+    inline T* end()                   { return begin() + count(); }
+    inline const T* end()       const { return begin() + count(); }
+    inline T& operator[](int32_t idx) { return begin()[idx]; }
+    inline const T& operator[](int32_t idx) const { return begin()[idx]; }
+    inline T& back()                  { return begin()[count() - 1u]; }
+    inline const T& back()      const { return begin()[count() - 1u]; }
+    inline void reserve(int32_t new_cap)
+    {
+        if(new_cap > capacity())
+        {
+            if(onHeap())
+            {
+                m_heap = (T*)Allocator::Realloc(
+                    t_bucket, 
+                    m_heap, 
+                    sizeof(T) * m_capacity, 
+                    sizeof(T) * new_cap);
+            }
+            else
+            {
+                T* heap = (T*)Allocator::Alloc(t_bucket, sizeof(T) * new_cap);
+                Copy(heap, (T*)m_inline, count());
+                m_heap = heap;
+            }
+            m_capacity = new_cap;
+        }
+    }
+    // copy constructs into an empty array
+    void copyFrom(const T* x, int32_t ct)
+    {
+        Assert(empty());
+        reserve(ct);
+        if(POD)
+        {
+            Copy(begin(), x, ct);
+        }
+        else
+        {
+            T* data = begin();
+            for(int32_t i = 0; i < ct; ++i)
+            {
+                new (data + i) T(x[i]);
+            }
+        }
+        m_count = ct;
+    }
+    inline void expand(int32_t step)
+    {
+        int32_t newCount = count() + step;
+        if(newCount > capacity())
+        {
+            reserve(Max(capacity() * 2, newCount));
+        }
+    }
+    void resize(const int32_t new_size)
+    {
+        if(new_size > capacity())
+        {
+            reserve(new_size);
+        }
+        if(!POD)
+        {
+            T* data = begin();
+            for(int32_t i = m_count - 1; i >= new_size; --i)
+            {
+                (data + i)->~T();
+            }
+            for(int32_t i = m_count; i < new_size; ++i)
+            {
+                new (data + i) T();
+            }
+        }
+        m_count = new_size;
+    }
+    inline T& append()
+    {
+        Assert(count() != capacity());
+        ++m_count;
+        if(!POD)
+        {
+            new (&back()) T();
+        }
+        return back();
+    }
+    inline T& grow()
+    {
+        if(count() == capacity())
+        {
+            reserve(capacity() * 2);
+        }
+        ++m_count;
+        if(!POD)
+        {
+            new (&back()) T();
+        }
+        return back();
+    }
+    template<typename... Args>
+    inline T& emplace(Args&&... args)
+    {
+        if(count() == capacity())
+        {
+            reserve(capacity() * 2);
+        }
+        new (begin() + m_count) T(std::forward<Args>(args)...);
+        ++m_count;
+        return back();
+    }
+    inline T& push(const T& t)
+    {
+        return emplace(t);
+    }
+    inline T& push(T&& t)
+    {
+        return emplace(std::move(t));
+    }
+    inline void pop()
+    {
+        Assert(!empty());
+        if(!POD)
+        {
+            (&back())->~T();
+        }
+        --m_count;
+    }
+    inline void clear() 
+    {
+        if(!POD)
+        {
+            T* data = begin();
+            for(int32_t i = 0; i < m_count; ++i)
+            {
+                (data + i)->~T();
+            }
+        }
+        m_count = 0; 
+    }
+    inline void reset()
+    {
+        clear();
+        if(onHeap())
+        {
+            Allocator::Free(t_bucket, m_heap);
+        }
+        MemZero(*this);
+    }
+    inline void remove(int32_t idx)
+    {
+        if(idx != count() - 1)
+        {
+            begin()[idx] = std::move(back());
+        }
+        pop();
+    }
+    inline void shiftRemove(int32_t idx)
+    {
+        T* data = begin();
+        for(int32_t i = idx + 1; i < count(); ++i)
+        {
+            data[i - 1] = std::move(data[i]);
+        }
+        pop();
+    }
+    int32_t find(const T& t) const
+    {
+        const T* data = begin();
+        for(int32_t i = 0; i < count(); ++i)
+        {
+            if(data[i] == t)
+                return i;
+        }
+        return -1;
+    }
+    inline int32_t findOrPush(const T& t)
+    {
+        int32_t idx = find(t);
+        if(idx == -1)
+        {
+            idx = count();
+            push(t);
+        }
+        return idx;
+    }
+    inline bool findRemove(const T& t)
+    {
+        int32_t idx = find(t);
+        if(idx != -1)
+        {
+            remove(idx);
+            return true;
+        }
+        return false;
+    }
+};
+
+template<typename T, int32_t N, bool POD, AllocBucket t_bucket>
+struct TriviallyRelocatable<SmallArray<T, N, POD, t_bucket>>
+{
+    static constexpr bool value = true;
+};
+
 template<typename A, typename B, AllocBucket t_bucket = AB_Default>
 struct Array2
 {
@@ -357,13 +669,13 @@ struct Array2
     {
         if(newCap > capacity())
         {
+            size_t oldBytes = sizeof(A) * capacity() + sizeof(B) * capacity();
             size_t bytes = sizeof(A) * newCap + sizeof(B) * newCap;
-            uint8_t* data = (uint8_t*)Allocator::Alloc(t_bucket, bytes);
+            uint8_t* data = (uint8_t*)Allocator::Realloc(t_bucket, m_data, oldBytes, bytes);
 
-            Copy((A*)data, beginA(), count());
-            Copy((B*)(data + sizeof(A) * newCap), beginB(), count());
+            // As stay put, Bs slide up past the larger A section
+            memmove(data + sizeof(A) * newCap, data + sizeof(A) * capacity(), sizeof(B) * count());
 
-            Allocator::Free(t_bucket, m_data);
             m_data = data;
             m_capacity = newCap;
         }
@@ -442,6 +754,12 @@ struct Array2
     }
 };
 
+template<typename A, typename B, AllocBucket t_bucket>
+struct TriviallyRelocatable<Array2<A, B, t_bucket>>
+{
+    static constexpr bool value = true;
+};
+
 template<typename T, int32_t m_capacity>
 struct FixedArray
 {
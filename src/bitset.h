@@ -0,0 +1,326 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+#include "macro.h"
+#include "allocator.h"
+#include "array.h"
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif // _MSC_VER
+
+inline int32_t CountTrailingZeros64(uint64_t x)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return (int32_t)idx;
+#else
+    return __builtin_ctzll(x);
+#endif // _MSC_VER
+}
+
+inline int32_t PopCount64(uint64_t x)
+{
+#ifdef _MSC_VER
+    return (int32_t)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif // _MSC_VER
+}
+
+// calls fn(index) for each set bit of a word, lowest first
+template<typename T>
+inline void ForEachBit(uint64_t word, int32_t base, T& fn)
+{
+    while(word)
+    {
+        fn(base + CountTrailingZeros64(word));
+        word &= word - 1u;
+    }
+}
+
+// growable bit array stored in 64 bit words. bits past Size() are always
+// zero, so the word-wise operations never need a tail mask.
+template<AllocBucket t_bucket = AB_Default>
+struct Bitset
+{
+    Array<uint64_t, true, t_bucket>     m_words;
+    int32_t                             m_size;
+
+    inline Bitset()
+    {
+        m_size = 0;
+    }
+
+    static inline int32_t WordCount(int32_t bits)
+    {
+        return (bits + 63) >> 6;
+    }
+    inline int32_t Size() const
+    {
+        return m_size;
+    }
+    // new bits are clear
+    inline void Resize(int32_t bits)
+    {
+        const int32_t oldWords = m_words.count();
+        const int32_t newWords = WordCount(bits);
+        m_words.resize(newWords);
+        if(newWords > oldWords)
+        {
+            memset(m_words.begin() + oldWords, 0, sizeof(uint64_t) * (newWords - oldWords));
+        }
+        if(bits & 63)
+        {
+            m_words.back() &= (1ull << (bits & 63)) - 1u;
+        }
+        m_size = bits;
+    }
+    inline void Reset()
+    {
+        m_words.reset();
+        m_size = 0;
+    }
+    inline void ClearAll()
+    {
+        if(!m_words.empty())
+        {
+            memset(m_words.begin(), 0, m_words.bytes());
+        }
+    }
+    inline bool Test(int32_t i) const
+    {
+        Assert(i >= 0 && i < m_size);
+        return (m_words[i >> 6] >> (i & 63)) & 1u;
+    }
+    inline void Set(int32_t i)
+    {
+        Assert(i >= 0 && i < m_size);
+        m_words[i >> 6] |= 1ull << (i & 63);
+    }
+    inline void Clear(int32_t i)
+    {
+        Assert(i >= 0 && i < m_size);
+        m_words[i >> 6] &= ~(1ull << (i & 63));
+    }
+    inline void Assign(int32_t i, bool value)
+    {
+        if(value)
+        {
+            Set(i);
+        }
+        else
+        {
+            Clear(i);
+        }
+    }
+    // grows to fit i first
+    inline void SetGrow(int32_t i)
+    {
+        if(i >= m_size)
+        {
+            Resize(i + 1);
+        }
+        Set(i);
+    }
+    inline bool TestSafe(int32_t i) const
+    {
+        return i >= 0 && i < m_size && Test(i);
+    }
+
+    // word-parallel operations. the other set may be shorter; missing bits
+    // count as zero.
+    inline void And(const Bitset& other)
+    {
+        const int32_t common = Min(m_words.count(), other.m_words.count());
+        for(int32_t i = 0; i < common; ++i)
+        {
+            m_words[i] &= other.m_words[i];
+        }
+        for(int32_t i = common; i < m_words.count(); ++i)
+        {
+            m_words[i] = 0u;
+        }
+    }
+    // grows to the longer of the two
+    inline void Or(const Bitset& other)
+    {
+        if(other.m_size > m_size)
+        {
+            Resize(other.m_size);
+        }
+        for(int32_t i = 0; i < other.m_words.count(); ++i)
+        {
+            m_words[i] |= other.m_words[i];
+        }
+    }
+    inline void AndNot(const Bitset& other)
+    {
+        const int32_t common = Min(m_words.count(), other.m_words.count());
+        for(int32_t i = 0; i < common; ++i)
+        {
+            m_words[i] &= ~other.m_words[i];
+        }
+    }
+    inline int32_t PopCount() const
+    {
+        int32_t count = 0;
+        for(uint64_t word : m_words)
+        {
+            count += PopCount64(word);
+        }
+        return count;
+    }
+    inline bool Any() const
+    {
+        for(uint64_t word : m_words)
+        {
+            if(word)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    // first set bit at or after i, -1 if none
+    inline int32_t FindNext(int32_t i) const
+    {
+        if(i >= m_size)
+        {
+            return -1;
+        }
+        int32_t w = i >> 6;
+        uint64_t word = m_words[w] & (~0ull << (i & 63));
+        while(!word)
+        {
+            if(++w == m_words.count())
+            {
+                return -1;
+            }
+            word = m_words[w];
+        }
+        return (w << 6) + CountTrailingZeros64(word);
+    }
+    template<typename T>
+    inline void ForEach(T fn) const
+    {
+        for(int32_t w = 0; w < m_words.count(); ++w)
+        {
+            ForEachBit(m_words[w], w << 6, fn);
+        }
+    }
+    // iterates this & other without building the intersection
+    template<typename T>
+    inline void ForEachAnd(const Bitset& other, T fn) const
+    {
+        const int32_t common = Min(m_words.count(), other.m_words.count());
+        for(int32_t w = 0; w < common; ++w)
+        {
+            ForEachBit(m_words[w] & other.m_words[w], w << 6, fn);
+        }
+    }
+};
+
+template<AllocBucket t_bucket>
+struct TriviallyRelocatable<Bitset<t_bucket>>
+{
+    static constexpr bool value = true;
+};
+
+// fixed size bitset that tasks can set and clear bits in concurrently.
+// bits are published with relaxed ordering; the task barrier orders them
+// against the reading thread.
+template<AllocBucket t_bucket = AB_Default>
+struct AtomicBitset
+{
+    std::atomic<uint64_t>*  m_words;
+    int32_t                 m_size;
+
+    inline AtomicBitset()
+    {
+        m_words = nullptr;
+        m_size = 0;
+    }
+    ~AtomicBitset()
+    {
+        Reset();
+    }
+    AtomicBitset(const AtomicBitset&) = delete;
+    AtomicBitset& operator=(const AtomicBitset&) = delete;
+
+    inline int32_t WordCount() const
+    {
+        return (m_size + 63) >> 6;
+    }
+    inline int32_t Size() const
+    {
+        return m_size;
+    }
+    // all bits start clear; not thread safe
+    inline void Init(int32_t bits)
+    {
+        Reset();
+        m_size = bits;
+        m_words = (std::atomic<uint64_t>*)Allocator::Alloc(t_bucket, sizeof(uint64_t) * WordCount());
+        for(int32_t i = 0; i < WordCount(); ++i)
+        {
+            new (m_words + i) std::atomic<uint64_t>(0u);
+        }
+    }
+    inline void Reset()
+    {
+        Allocator::Free(t_bucket, m_words);
+        m_words = nullptr;
+        m_size = 0;
+    }
+    inline bool Test(int32_t i) const
+    {
+        Assert(i >= 0 && i < m_size);
+        return (m_words[i >> 6].load(std::memory_order_relaxed) >> (i & 63)) & 1u;
+    }
+    // returns the previous value
+    inline bool Set(int32_t i)
+    {
+        Assert(i >= 0 && i < m_size);
+        const uint64_t bit = 1ull << (i & 63);
+        return (m_words[i >> 6].fetch_or(bit, std::memory_order_relaxed) & bit) != 0u;
+    }
+    inline bool Clear(int32_t i)
+    {
+        Assert(i >= 0 && i < m_size);
+        const uint64_t bit = 1ull << (i & 63);
+        return (m_words[i >> 6].fetch_and(~bit, std::memory_order_relaxed) & bit) != 0u;
+    }
+    // the rest are meant for after the writers are done
+    inline int32_t PopCount() const
+    {
+        int32_t count = 0;
+        for(int32_t i = 0; i < WordCount(); ++i)
+        {
+            count += PopCount64(m_words[i].load(std::memory_order_relaxed));
+        }
+        return count;
+    }
+    template<typename T>
+    inline void ForEach(T fn) const
+    {
+        for(int32_t w = 0; w < WordCount(); ++w)
+        {
+            ForEachBit(m_words[w].load(std::memory_order_relaxed), w << 6, fn);
+        }
+    }
+    template<AllocBucket t_other>
+    inline void CopyTo(Bitset<t_other>& out) const
+    {
+        out.Resize(m_size);
+        for(int32_t i = 0; i < WordCount(); ++i)
+        {
+            out.m_words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+    }
+};
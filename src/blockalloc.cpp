@@ -0,0 +1,310 @@
+#include "blockalloc.h"
+
+#include "macro.h"
+#include "sort.h"
+
+thread_local BlockAlloc::Cache BlockAlloc::ts_caches[MaxCachedPools];
+
+// epochs are never reused, so a stale cache can't match a newer pool
+static std::atomic<uint32_t> ms_epoch(1u);
+static std::atomic<int32_t>  ms_slots(0);
+
+BlockAlloc::BlockAlloc()
+{
+    m_depot = nullptr;
+    m_depotCount = 0;
+    m_trimDepot = 0;
+    m_capacity = 0;
+    m_itemSize = 0;
+    m_startItems = 8;
+    m_blockItems = 8;
+    m_slot = -1;
+    m_epoch = 0u;
+    m_zero = true;
+    m_live = 0;
+    m_peak = 0;
+}
+
+BlockAlloc::~BlockAlloc()
+{
+    ReleaseBlocks();
+}
+
+void BlockAlloc::Init(int32_t itemSize, int32_t blockSize, bool zero)
+{
+    ReleaseBlocks();
+    // free items hold the list link, so the size is rounded up to a Node and
+    // to its 8 byte alignment. blocks come 16 byte aligned from AB_Default and
+    // sizeof(T) is a multiple of alignof(T), so items are aligned for T as long
+    // as alignof(T) <= 16, which Init<T> checks. raw sizes only get 8 bytes.
+    m_itemSize = Max(itemSize, (int32_t)sizeof(Node));
+    m_itemSize = (m_itemSize + (int32_t)alignof(Node) - 1) & ~((int32_t)alignof(Node) - 1);
+    m_startItems = Max(blockSize, 1);
+    m_blockItems = m_startItems;
+    m_zero = zero;
+    if(m_slot == -1)
+    {
+        const int32_t slot = ms_slots.fetch_add(1, std::memory_order_relaxed);
+        m_slot = slot < MaxCachedPools ? slot : -1;
+    }
+}
+
+void BlockAlloc::Reset(int32_t blockSize)
+{
+    LockGuard guard(m_lock);
+    ReleaseBlocks();
+    m_startItems = Max(blockSize, 1);
+    m_blockItems = m_startItems;
+}
+
+void BlockAlloc::ReleaseBlocks()
+{
+    for(const Block& block : m_blocks)
+    {
+        Allocator::Free(AB_Default, block.items);
+    }
+    m_blocks.reset();
+    m_depot = nullptr;
+    m_depotCount = 0;
+    m_trimDepot = 0;
+    m_capacity = 0;
+    m_live = 0;
+    m_peak = 0;
+    m_epoch = ms_epoch.fetch_add(1u, std::memory_order_relaxed);
+}
+
+void BlockAlloc::Grow()
+{
+    Assert(m_itemSize > 0);
+    const int32_t count = m_blockItems;
+    uint8_t* items = (uint8_t*)Allocator::Alloc(AB_Default, (size_t)count * m_itemSize);
+    Block& block = m_blocks.grow();
+    block.items = items;
+    block.count = count;
+    m_capacity += count;
+
+    // push in reverse so items come out in address order
+    for(int32_t i = count - 1; i >= 0; --i)
+    {
+        Node* node = (Node*)(items + (size_t)i * m_itemSize);
+        node->next = m_depot;
+        m_depot = node;
+    }
+    m_depotCount += count;
+
+    const int32_t maxItems = Max(m_startItems, MaxBlockBytes / m_itemSize);
+    m_blockItems = Min(m_blockItems * 2, maxItems);
+}
+
+void BlockAlloc::FoldLive(Cache& cache)
+{
+    m_live += cache.live;
+    m_peak = Max(m_peak, m_live);
+    cache.live = 0;
+}
+
+void BlockAlloc::Refill(Cache& cache)
+{
+    LockGuard guard(m_lock);
+    FoldLive(cache);
+    if(!m_depot)
+    {
+        Grow();
+    }
+    for(int32_t i = 0; i < BatchSize && m_depot; ++i)
+    {
+        Node* node = m_depot;
+        m_depot = node->next;
+        --m_depotCount;
+        node->next = cache.head;
+        cache.head = node;
+        ++cache.count;
+    }
+}
+
+void BlockAlloc::Drain(Cache& cache)
+{
+    LockGuard guard(m_lock);
+    FoldLive(cache);
+    for(int32_t i = 0; i < BatchSize; ++i)
+    {
+        Node* node = cache.head;
+        cache.head = node->next;
+        --cache.count;
+        node->next = m_depot;
+        m_depot = node;
+        ++m_depotCount;
+    }
+    MaybeTrim();
+}
+
+BlockAlloc::Node* BlockAlloc::AllocShared()
+{
+    LockGuard guard(m_lock);
+    if(!m_depot)
+    {
+        Grow();
+    }
+    Node* node = m_depot;
+    m_depot = node->next;
+    --m_depotCount;
+    ++m_live;
+    m_peak = Max(m_peak, m_live);
+    return node;
+}
+
+void BlockAlloc::FreeShared(Node* node)
+{
+    LockGuard guard(m_lock);
+    node->next = m_depot;
+    m_depot = node;
+    ++m_depotCount;
+    --m_live;
+    MaybeTrim();
+}
+
+// trims once over half the pool is idle in the depot, and only again after
+// the depot doubles, so a fragmented pool doesn't rescan on every free
+void BlockAlloc::MaybeTrim()
+{
+    if(m_depotCount * 2 > m_capacity &&
+        m_depotCount > m_startItems &&
+        m_depotCount >= m_trimDepot * 2)
+    {
+        TrimLocked();
+        m_trimDepot = m_depotCount;
+    }
+}
+
+int32_t BlockAlloc::Trim()
+{
+    LockGuard guard(m_lock);
+    // the calling thread's cache can be checked too
+    if(m_slot != -1)
+    {
+        Cache& cache = GetCache();
+        FoldLive(cache);
+        while(cache.head)
+        {
+            Node* node = cache.head;
+            cache.head = node->next;
+            node->next = m_depot;
+            m_depot = node;
+            ++m_depotCount;
+        }
+        cache.count = 0;
+    }
+    const int32_t released = TrimLocked();
+    m_trimDepot = m_depotCount;
+    return released;
+}
+
+int32_t BlockAlloc::TrimLocked()
+{
+    if(!m_depot)
+    {
+        return 0;
+    }
+
+    const int32_t blockCount = m_blocks.count();
+    Sort(m_blocks.begin(), blockCount, [](const Block& a, const Block& b)
+    {
+        return a.items < b.items;
+    });
+
+    TempScope scope;
+    int32_t* freeCounts = (int32_t*)Allocator::Alloc(AB_Temp, sizeof(int32_t) * blockCount);
+    memset(freeCounts, 0, sizeof(int32_t) * blockCount);
+
+    auto blockOf = [&](const Node* node)
+    {
+        int32_t lo = 0;
+        int32_t hi = blockCount - 1;
+        while(lo < hi)
+        {
+            const int32_t mid = (lo + hi + 1) >> 1;
+            if(m_blocks[mid].items <= (const uint8_t*)node)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        return lo;
+    };
+
+    for(const Node* node = m_depot; node; node = node->next)
+    {
+        ++freeCounts[blockOf(node)];
+    }
+
+    int32_t released = 0;
+    for(int32_t i = 0; i < blockCount; ++i)
+    {
+        if(freeCounts[i] == m_blocks[i].count)
+        {
+            ++released;
+        }
+    }
+    if(!released)
+    {
+        return 0;
+    }
+
+    // unlink nodes of the released blocks, keeping the depot order
+    Node** link = &m_depot;
+    while(*link)
+    {
+        Node* node = *link;
+        const int32_t b = blockOf(node);
+        if(freeCounts[b] == m_blocks[b].count)
+        {
+            *link = node->next;
+            --m_depotCount;
+        }
+        else
+        {
+            link = &node->next;
+        }
+    }
+
+    int32_t kept = 0;
+    for(int32_t i = 0; i < blockCount; ++i)
+    {
+        if(freeCounts[i] == m_blocks[i].count)
+        {
+            m_capacity -= m_blocks[i].count;
+            Allocator::Free(AB_Default, m_blocks[i].items);
+        }
+        else
+        {
+            m_blocks[kept++] = m_blocks[i];
+        }
+    }
+    m_blocks.resize(kept);
+
+    // start small again when the pool is growing back from empty
+    if(m_blocks.empty())
+    {
+        m_blockItems = m_startItems;
+    }
+    return released;
+}
+
+BlockAllocStats BlockAlloc::GetStats()
+{
+    LockGuard guard(m_lock);
+    BlockAllocStats stats;
+    stats.blocks = m_blocks.count();
+    stats.capacity = m_capacity;
+    if(m_slot != -1)
+    {
+        FoldLive(GetCache());
+    }
+    stats.live = m_live;
+    stats.peak = m_peak;
+    stats.bytes = (size_t)m_capacity * m_itemSize;
+    return stats;
+}
@@ -1,62 +1,200 @@
 #pragma once
 
 #include "array.h"
+#include "allocator.h"
+#include "sema.h"
 #include <stdlib.h>
 #include <new>
+#include <atomic>
 
-template<typename T, int32_t start_size = 8>
-struct TBlockAlloc
+struct BlockAllocStats
 {
-    Array<T*> m_blocks;
-    Array<T*> m_free;
-    int32_t   m_blockSize;
+    int32_t     blocks;
+    int32_t     capacity;
+    int32_t     live;
+    int32_t     peak;
+    size_t      bytes;
+};
 
-    TBlockAlloc()
+// pool of fixed size items. free items are linked through their own first
+// bytes. each thread keeps a short free list per pool and trades items with
+// a shared depot in batches, so Alloc and Free usually take no lock. blocks
+// double in size up to MaxBlockBytes, and blocks whose items are all back in
+// the depot are released by Trim(), which also runs on its own once most of
+// the pool sits unused. items left in the cache of a thread that exits stay
+// out of circulation until Reset.
+struct BlockAlloc
+{
+    static constexpr int32_t MaxBlockBytes  = 1 << 16;
+    static constexpr int32_t BatchSize      = 32;
+    static constexpr int32_t MaxCachedPools = 64;
+
+    struct Node
+    {
+        Node* next;
+    };
+    struct Block
     {
-        m_blockSize = start_size;
+        uint8_t*    items;
+        int32_t     count;
+    };
+    struct Cache
+    {
+        Node*       head;
+        int32_t     count;
+        // allocs minus frees not yet folded into m_live
+        int32_t     live;
+        uint32_t    epoch;
+    };
+
+    std::mutex              m_lock;
+    Node*                   m_depot;
+    int32_t                 m_depotCount;
+    int32_t                 m_trimDepot;
+    Array<Block>            m_blocks;
+    int32_t                 m_capacity;
+    int32_t                 m_itemSize;
+    int32_t                 m_startItems;
+    int32_t                 m_blockItems;
+    int32_t                 m_slot;
+    uint32_t                m_epoch;
+    bool                    m_zero;
+    int32_t                 m_live;
+    int32_t                 m_peak;
+
+    // slot -1 pools bypass the thread caches
+    static thread_local Cache ts_caches[MaxCachedPools];
+
+    BlockAlloc();
+    ~BlockAlloc();
+    BlockAlloc(const BlockAlloc&) = delete;
+    BlockAlloc& operator=(const BlockAlloc&) = delete;
+
+    // zero clears each item on Alloc
+    template<typename T>
+    inline void Init(int32_t blockSize = 8, bool zero = true)
+    {
+        static_assert(alignof(T) <= 16, "BlockAlloc blocks are only 16 byte aligned");
+        Init(sizeof(T), blockSize, zero);
     }
-    ~TBlockAlloc()
+    void Init(int32_t itemSize, int32_t blockSize, bool zero);
+    // releases every block; outstanding items become invalid
+    void Reset(int32_t blockSize = 8);
+    // releases blocks with no live items, returns how many
+    int32_t Trim();
+    // live and peak are folded in as threads trade batches with the depot,
+    // so they can lag by a few batches per thread
+    BlockAllocStats GetStats();
+
+    inline Cache& GetCache()
     {
-        Reset();
+        Cache& cache = ts_caches[m_slot];
+        // the pool was reset since this thread last used it
+        if(cache.epoch != m_epoch)
+        {
+            cache.head = nullptr;
+            cache.count = 0;
+            cache.live = 0;
+            cache.epoch = m_epoch;
+        }
+        return cache;
     }
-    void Reset()
+    inline void* Alloc()
     {
-        for(T* block : m_blocks)
+        Node* node;
+        if(m_slot != -1)
         {
-            free(block);
+            Cache& cache = GetCache();
+            if(!cache.head)
+            {
+                Refill(cache);
+            }
+            node = cache.head;
+            cache.head = node->next;
+            --cache.count;
+            ++cache.live;
         }
-        m_free.reset();
-        m_blocks.reset();
-        m_blockSize = start_size;
+        else
+        {
+            node = AllocShared();
+        }
+        if(m_zero)
+        {
+            memset(node, 0, m_itemSize);
+        }
+        return node;
     }
-    T* Alloc()
+    inline void Free(void* p)
     {
-        if(m_free.empty())
+        if(!p)
+        {
+            return;
+        }
+        Node* node = (Node*)p;
+        if(m_slot != -1)
         {
-            T* items = (T*)calloc(m_blockSize, sizeof(T));
-            m_blocks.grow() = items;
-            m_free.expand(m_blockSize);
-            for(int32_t i = m_blockSize - 1; i >= 0; --i)
+            Cache& cache = GetCache();
+            node->next = cache.head;
+            cache.head = node;
+            --cache.live;
+            if(++cache.count > BatchSize * 2)
             {
-                m_free.append() = items + i;
+                Drain(cache);
             }
-            m_blockSize *= 2;
         }
-        T* t = m_free.back();
-        m_free.pop();
-        memset(t, 0, sizeof(T));
-        return t;
+        else
+        {
+            FreeShared(node);
+        }
+    }
+
+    // slow paths, all under m_lock
+    void Refill(Cache& cache);
+    void Drain(Cache& cache);
+    Node* AllocShared();
+    void FreeShared(Node* node);
+    void Grow();
+    void MaybeTrim();
+    int32_t TrimLocked();
+    void ReleaseBlocks();
+    void FoldLive(Cache& cache);
+};
+
+template<typename T, int32_t start_size = 8, bool t_zero = true>
+struct TBlockAlloc
+{
+    BlockAlloc m_pool;
+
+    TBlockAlloc()
+    {
+        m_pool.Init<T>(start_size, t_zero);
+    }
+    void Reset()
+    {
+        m_pool.Reset(start_size);
+    }
+    inline T* Alloc()
+    {
+        return (T*)m_pool.Alloc();
     }
     inline void Free(T* c)
     {
-        m_free.grow() = c;
+        m_pool.Free(c);
+    }
+    inline int32_t Trim()
+    {
+        return m_pool.Trim();
+    }
+    inline BlockAllocStats GetStats()
+    {
+        return m_pool.GetStats();
     }
 };
 
 template<typename T, int32_t start_size = 8>
 struct TBlockAllocCD
 {
-    TBlockAlloc<T, start_size> m_block;
+    TBlockAlloc<T, start_size, false> m_block;
 
     inline T* Alloc()
     {
@@ -73,58 +211,3 @@ struct TBlockAllocCD
         }
     }
 };
-
-struct BlockAlloc
-{
-    Array<void*>    m_free;
-    Array<uint8_t*> m_blocks;
-    int32_t         m_itemSize;
-    int32_t         m_blockSize;
-
-    template<typename T>
-    void Init(int32_t blockSize = 8)
-    {
-        m_itemSize = sizeof(T);
-        m_blockSize = blockSize;
-        m_free.reserve(m_blockSize);
-    }
-    ~BlockAlloc()
-    {
-        for(uint8_t* block : m_blocks)
-        {
-            free(block);
-        }
-    }
-    void Reset(int32_t blockSize = 8)
-    {
-        for(uint8_t* block : m_blocks)
-        {
-            free(block);
-        }
-        m_free.reset();
-        m_blocks.reset();
-        m_blockSize = blockSize;
-    }
-    void* Alloc()
-    {
-        if(m_free.empty())
-        {
-            uint8_t* items = (uint8_t*)calloc(m_blockSize, m_itemSize);
-            m_blocks.grow() = items;
-            m_free.expand(m_blockSize);
-            for(int32_t i = m_blockSize - 1; i >= 0; --i)
-            {
-                m_free.append() = items + i * m_itemSize;
-            }
-            m_blockSize *= 2;
-        }
-        void* t = m_free.back();
-        m_free.pop();
-        memset(t, 0, m_itemSize);
-        return t;
-    }
-    inline void Free(void* c)
-    {
-        m_free.grow() = c;
-    }
-};
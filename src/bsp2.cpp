@@ -95,6 +95,8 @@ struct csgmodel
 };
 
 typedef TempArray<csgpolygon, false> polylist;
+// split polygons rarely exceed a handful of vertices
+typedef SmallArray<vec3, 6, true, AB_Temp> polyverts;
 
 struct csgplane
 {
@@ -121,7 +123,7 @@ struct csgplane
         return glm::dot(normal, x) - w;
     }
     void splitPolygon(
-        const csgpolygon& polygon, 
+        csgpolygon&& polygon, 
         polylist& cofront,
         polylist& coback,
         polylist& front,
@@ -130,14 +132,14 @@ struct csgplane
 
 struct csgpolygon
 {
-    TempArray<vec3> vertices;
+    polyverts vertices;
     csgplane plane;
 
     csgpolygon() {}
-    csgpolygon(const TempArray<vec3>& list)
+    csgpolygon(polyverts&& list)
     {
         plane = csgplane(list[0], list[1], list[2]);
-        vertices = list;
+        vertices = std::move(list);
     }
     inline void flip()
     {
@@ -149,6 +151,8 @@ struct csgpolygon
     }
 };
 
+TRIVIALLY_RELOCATABLE(csgpolygon)
+
 struct csgnode
 {
     polylist polygons;
@@ -160,10 +164,10 @@ struct csgnode
     {
         memset(this, 0, sizeof(*this));
     }
-    csgnode(const polylist& list)
+    csgnode(polylist&& list)
     {
         memset(this, 0, sizeof(*this));
-        build(list);
+        build(std::move(list));
     }
     ~csgnode()
     {
@@ -173,13 +177,13 @@ struct csgnode
     csgnode* clone() const;
     void clipTo(const csgnode* other);
     void invert();
-    void build(const polylist& list);
-    polylist clipPolygons(const polylist& list) const;
+    void build(polylist&& list);
+    polylist clipPolygons(polylist&& list) const;
     polylist allPolygons() const;
 };
 
 void csgplane::splitPolygon(
-    const csgpolygon& polygon, 
+    csgpolygon&& polygon, 
     polylist& cofront,
     polylist& coback,
     polylist& front,
@@ -194,7 +198,7 @@ void csgplane::splitPolygon(
     };
 
     uint32_t polygonType = 0u;
-    TempArray<uint32_t> types;
+    SmallArray<uint32_t, 16, true, AB_Temp> types;
 
     types.expand(polygon.vertices.count());
     for(const auto& x : polygon.vertices)
@@ -212,27 +216,27 @@ void csgplane::splitPolygon(
         {
             if(glm::dot(normal, polygon.plane.normal) > 0.0f)
             {
-                cofront.grow() = polygon;
+                cofront.push(std::move(polygon));
             }
             else
             {
-                coback.grow() = polygon;
+                coback.push(std::move(polygon));
             }
         }
         break;
         case Front:
         {
-            front.grow() = polygon;
+            front.push(std::move(polygon));
         }
         break;
         case Back:
         {
-            back.grow() = polygon;
+            back.push(std::move(polygon));
         }
         break;
         case Spanning:
         {
-            TempArray<vec3> f, b;
+            polyverts f, b;
             for(int32_t i = 0; i < polygon.vertices.count(); ++i)
             {
                 int32_t j = (i + 1) % polygon.vertices.count();
@@ -258,11 +262,11 @@ void csgplane::splitPolygon(
             }
             if(f.count() >= 3)
             {
-                front.grow() = csgpolygon(f);
+                front.emplace(std::move(f));
             }
             if(b.count() >= 3)
             {
-                back.grow() = csgpolygon(b);
+                back.emplace(std::move(b));
             }
         }
         break;
@@ -335,61 +339,56 @@ void csgnode::invert()
     }
 }
 
-struct ClipPair
-{
-    const csgnode* node;
-    polylist list;
-};
-
-static void csgnode_clipPolygons(const ClipPair& pair, polylist& result)
+// consumes list, moving the surviving polygons into result
+static void csgnode_clipPolygons(const csgnode* node, polylist& list, polylist& result)
 {
-    if(!pair.node->plane.ok())
+    if(!node->plane.ok())
     {
-        result.expand(pair.list.count());
-        for(const auto& x : pair.list)
+        result.expand(list.count());
+        for(auto& x : list)
         {
-            result.append() = x;
+            result.push(std::move(x));
         }
         return;
     }
 
     polylist lfront, lback;
-    for(int32_t i = 0; i < pair.list.count(); ++i)
+    for(auto& x : list)
     {
-        pair.node->plane.splitPolygon(pair.list[i], lfront, lback, lfront, lback);
+        node->plane.splitPolygon(std::move(x), lfront, lback, lfront, lback);
     }
 
-    if(pair.node->front)
+    if(node->front)
     {
-        csgnode_clipPolygons({ pair.node->front, lfront }, result);
+        csgnode_clipPolygons(node->front, lfront, result);
     }
     else
     {
         result.expand(lfront.count());
-        for(const auto& x : lfront)
+        for(auto& x : lfront)
         {
-            result.append() = x;
+            result.push(std::move(x));
         }
     }
 
-    if(pair.node->back)
+    if(node->back)
     {
-        csgnode_clipPolygons({ pair.node->back, lback }, result);
+        csgnode_clipPolygons(node->back, lback, result);
     }
 }
 
-polylist csgnode::clipPolygons(const polylist& list) const 
+polylist csgnode::clipPolygons(polylist&& list) const 
 {
     polylist result;
 
-    csgnode_clipPolygons({ this, list }, result);
+    csgnode_clipPolygons(this, list, result);
 
     return result;
 }
 
 void csgnode::clipTo(const csgnode* other)
 {
-    polygons = other->clipPolygons(polygons);
+    polygons = other->clipPolygons(std::move(polygons));
     if(front)
     {
         front->clipTo(other);
@@ -407,7 +406,7 @@ static void csgnode_allPolygons(polylist& result, const csgnode* x)
         result.expand(x->polygons.count());
         for(const auto& p : x->polygons)
         {
-            result.append() = p;
+            result.push(p);
         }
         csgnode_allPolygons(result, x->front);
         csgnode_allPolygons(result, x->back);
@@ -437,7 +436,7 @@ csgnode* csgnode::clone() const
     return node;
 }
 
-void csgnode::build(const polylist& list)
+void csgnode::build(polylist&& list)
 {
     if(list.empty())
     {
@@ -449,9 +448,9 @@ void csgnode::build(const polylist& list)
         plane = list[0].plane;
     }
     polylist lfront, lback;
-    for(const auto& x : list)
+    for(auto& x : list)
     {
-        plane.splitPolygon(x, polygons, polygons, lfront, lback);
+        plane.splitPolygon(std::move(x), polygons, polygons, lfront, lback);
     }
     if(lfront.count())
     {
@@ -459,7 +458,7 @@ void csgnode::build(const polylist& list)
         {
             front = Allocator::New<csgnode>(AB_Temp);
         }
-        front->build(lfront);
+        front->build(std::move(lfront));
     }
     if(lback.count())
     {
@@ -467,7 +466,7 @@ void csgnode::build(const polylist& list)
         {
             back = Allocator::New<csgnode>(AB_Temp);
         }
-        back->build(lback);
+        back->build(std::move(lback));
     }
 }
 
@@ -477,14 +476,14 @@ polylist modelToPolygon(const csgmodel& model)
     list.expand(model.vertices.count() / 3);
     for(int32_t i = 0; i + 2 < model.vertices.count(); i += 3)
     {
-        TempArray<vec3> tri;
+        polyverts tri;
         tri.resize(3);
         for(int32_t j = 0; j < 3; ++j)
         {
             vec3 v = model.vertices[i + j];
             tri[j] = v;
         }
-        list.append() = csgpolygon(tri);
+        list.emplace(std::move(tri));
     }
     return list;
 }
@@ -565,10 +564,20 @@ void Evaluate(const csglist& list, TempArray<vec3>& out)
     {
         return;
     }
-    csgmodel A = csgmodel(GetCSGPrim(list[0].m_prim));
-    A.Transform(list[0].m_matrix);
+    // running result lives on the heap so each operation's temp memory
+    // (bsp nodes, polygon lists) can be rolled back as soon as it finishes
+    Array<vec3> result;
+    {
+        TempScope scope;
+        csgmodel A = csgmodel(GetCSGPrim(list[0].m_prim));
+        A.Transform(list[0].m_matrix);
+        result.resize(A.vertices.count());
+        memcpy(result.begin(), A.vertices.begin(), result.bytes());
+    }
     for(int32_t i = 1; i < list.count(); ++i)
     {
+        TempScope scope;
+        csgmodel A = csgmodel(result);
         csgmodel B = csgmodel(GetCSGPrim(list[i].m_prim));
         B.Transform(list[i].m_matrix);
         switch(list[i].m_op)
@@ -589,7 +598,9 @@ void Evaluate(const csglist& list, TempArray<vec3>& out)
             }
             break;
         }
+        result.resize(A.vertices.count());
+        memcpy(result.begin(), A.vertices.begin(), result.bytes());
     }
-    out.resize(A.vertices.count());
-    memcpy(out.begin(), A.vertices.begin(), out.bytes());
+    out.resize(result.count());
+    memcpy(out.begin(), result.begin(), out.bytes());
 }
@@ -0,0 +1,232 @@
+#include "command.h"
+
+#include <atomic>
+#include "array.h"
+#include "macro.h"
+#include "sema.h"
+#include "sort.h"
+#include "allocator.h"
+
+enum CommandOp
+{
+    CO_Create = 0,
+    CO_Destroy,
+    CO_Add,
+    CO_Remove,
+    CO_Set,
+};
+
+struct Command
+{
+    slot        m_slot;
+    uint32_t    m_op;
+    // mask for CO_Create, component type otherwise
+    uint32_t    m_arg;
+    // CO_Set payload within the owning buffer's bytes
+    uint32_t    m_offset;
+    uint32_t    m_size;
+};
+
+struct CommandBuffer
+{
+    Array<Command>      m_commands;
+    Array<uint64_t>     m_keys;
+    Array<uint8_t>      m_bytes;
+    uint32_t            m_order;
+    uint32_t            m_sequence;
+};
+
+struct CommandEntry
+{
+    const Command*      m_command;
+    const uint8_t*      m_bytes;
+};
+
+// generation of placeholder slots from Create; real ones never get this high
+static constexpr uint32_t PendingGen = 0xFFFFFFFEu;
+
+namespace Commands
+{
+    std::mutex                          ms_lock;
+    Array<CommandBuffer*>               ms_buffers;
+    std::atomic<uint32_t>               ms_pending(0u);
+    // real slot of each placeholder, filled during Playback
+    Array<slot>                         ms_created;
+    // the one buffer allowed to record without an order, normally the
+    // main thread's; two would tie with nothing stable to break it
+    std::atomic<CommandBuffer*>         ms_unordered(nullptr);
+    thread_local CommandBuffer*         ts_buffer = nullptr;
+
+    CommandBuffer& GetBuffer()
+    {
+        if(!ts_buffer)
+        {
+            // lives as long as the program; pool threads never go away
+            ts_buffer = Allocator::New<CommandBuffer>(AB_Default);
+            ts_buffer->m_order = 0u;
+            ts_buffer->m_sequence = 0u;
+            LockGuard guard(ms_lock);
+            ms_buffers.grow() = ts_buffer;
+        }
+        return *ts_buffer;
+    }
+    Command& Record(CommandBuffer& buf, CommandOp op, slot s, uint32_t arg)
+    {
+        if(!buf.m_order)
+        {
+            CommandBuffer* owner = nullptr;
+            ms_unordered.compare_exchange_strong(owner, &buf);
+            Assert(!owner || owner == &buf);
+        }
+        // orders are unique per piece of work, which runs on one thread, so
+        // (order, sequence) never ties and doesn't depend on the thread
+        buf.m_keys.grow() = ((uint64_t)buf.m_order << 32) | buf.m_sequence++;
+        Command& cmd = buf.m_commands.grow();
+        cmd.m_slot = s;
+        cmd.m_op = op;
+        cmd.m_arg = arg;
+        cmd.m_offset = 0u;
+        cmd.m_size = 0u;
+        return cmd;
+    }
+    slot Create(ComponentMask mask)
+    {
+        slot s;
+        s.id = ms_pending.fetch_add(1u, std::memory_order_relaxed);
+        s.gen = PendingGen;
+        Record(GetBuffer(), CO_Create, s, mask);
+        return s;
+    }
+    void Destroy(slot s)
+    {
+        Record(GetBuffer(), CO_Destroy, s, 0u);
+    }
+    void Add(ComponentType type, slot s)
+    {
+        Record(GetBuffer(), CO_Add, s, type);
+    }
+    void Remove(ComponentType type, slot s)
+    {
+        Record(GetBuffer(), CO_Remove, s, type);
+    }
+    void Set(ComponentType type, slot s, const void* data, size_t size)
+    {
+        CommandBuffer& buf = GetBuffer();
+        Command& cmd = Record(buf, CO_Set, s, type);
+        cmd.m_offset = (uint32_t)buf.m_bytes.count();
+        cmd.m_size = (uint32_t)size;
+        buf.m_bytes.resize(buf.m_bytes.count() + (int32_t)size);
+        memcpy(buf.m_bytes.begin() + cmd.m_offset, data, size);
+    }
+    void SetOrder(uint32_t order)
+    {
+        CommandBuffer& buf = GetBuffer();
+        buf.m_order = order;
+        buf.m_sequence = 0u;
+    }
+    inline slot Resolve(slot s)
+    {
+        if(s.gen != PendingGen)
+        {
+            return s;
+        }
+        return s.id < (uint32_t)ms_created.count() ? ms_created[s.id] : slot();
+    }
+    void Playback()
+    {
+        LockGuard guard(ms_lock);
+        int32_t total = 0;
+        for(const CommandBuffer* buf : ms_buffers)
+        {
+            total += buf->m_commands.count();
+        }
+        if(!total)
+        {
+            return;
+        }
+
+        TempScope scope;
+        uint64_t* keys = (uint64_t*)Allocator::Alloc(AB_Temp, sizeof(uint64_t) * total);
+        CommandEntry* entries = (CommandEntry*)Allocator::Alloc(AB_Temp, sizeof(CommandEntry) * total);
+        slot* destroys = (slot*)Allocator::Alloc(AB_Temp, sizeof(slot) * total);
+        int32_t idx = 0;
+        for(const CommandBuffer* buf : ms_buffers)
+        {
+            for(int32_t i = 0; i < buf->m_commands.count(); ++i)
+            {
+                keys[idx] = buf->m_keys[i];
+                entries[idx].m_command = &buf->m_commands[i];
+                entries[idx].m_bytes = buf->m_bytes.begin();
+                ++idx;
+            }
+        }
+        SortByKey(keys, entries, total);
+
+        const int32_t pending = (int32_t)ms_pending.load(std::memory_order_relaxed);
+        ms_created.resize(pending);
+        for(slot& s : ms_created)
+        {
+            s = slot();
+        }
+
+        // runs of destroys go out together so physics is torn down in one batch
+        int32_t destroyCount = 0;
+        for(int32_t i = 0; i < total; ++i)
+        {
+            const Command& cmd = *entries[i].m_command;
+            if(cmd.m_op != CO_Destroy && destroyCount)
+            {
+                Components::DestroyBatch(destroys, destroyCount);
+                destroyCount = 0;
+            }
+            const ComponentType type = (ComponentType)cmd.m_arg;
+            switch(cmd.m_op)
+            {
+                case CO_Create:
+                    Components::CreateBatch(1, cmd.m_arg, &ms_created[cmd.m_slot.id]);
+                break;
+                case CO_Destroy:
+                    destroys[destroyCount++] = Resolve(cmd.m_slot);
+                break;
+                case CO_Add:
+                    Components::Add(type, Resolve(cmd.m_slot));
+                break;
+                case CO_Remove:
+                    Components::Remove(type, Resolve(cmd.m_slot));
+                break;
+                case CO_Set:
+                {
+                    void* dst = Components::GetAdd(type, Resolve(cmd.m_slot));
+                    if(dst)
+                    {
+                        memcpy(dst, entries[i].m_bytes + cmd.m_offset, cmd.m_size);
+                    }
+                }
+                break;
+            }
+        }
+        if(destroyCount)
+        {
+            Components::DestroyBatch(destroys, destroyCount);
+        }
+
+        for(CommandBuffer* buf : ms_buffers)
+        {
+            buf->m_commands.clear();
+            buf->m_keys.clear();
+            buf->m_bytes.clear();
+        }
+        ms_created.clear();
+        ms_pending.store(0u, std::memory_order_relaxed);
+    }
+    int32_t PendingCount()
+    {
+        LockGuard guard(ms_lock);
+        int32_t total = 0;
+        for(const CommandBuffer* buf : ms_buffers)
+        {
+            total += buf->m_commands.count();
+        }
+        return total;
+    }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "component.h"
+
+// structural changes recorded from any thread and applied later on the main
+// thread by Playback. each thread appends to its own buffer, so recording
+// takes no lock. commands are ordered by (order, sequence) rather than by
+// arrival, so the result doesn't depend on which thread ran what: each
+// piece of parallel work calls SetOrder with a nonzero value unique to it
+// first, and SetOrder(0) when done. order 0 is reserved for one thread,
+// normally the main one. Systems::Update orders by system then chunk and
+// plays back after every wave.
+namespace Commands
+{
+    // records an entity holding every type in mask. the returned slot is a
+    // placeholder only valid as an argument to later commands before the
+    // next Playback; it can't be passed to Components.
+    slot Create(ComponentMask mask);
+    void Destroy(slot s);
+    void Add(ComponentType type, slot s);
+    void Remove(ComponentType type, slot s);
+    // adds the component if missing and copies size bytes over it
+    void Set(ComponentType type, slot s, const void* data, size_t size);
+    // starts a new ordering key for the calling thread's later commands
+    void SetOrder(uint32_t order);
+    // applies every recorded command; main thread only, with no recording
+    // in flight
+    void Playback();
+    int32_t PendingCount();
+
+    template<typename T>
+    inline void Add(slot s)
+    {
+        Add(T::ms_type, s);
+    }
+    template<typename T>
+    inline void Remove(slot s)
+    {
+        Remove(T::ms_type, s);
+    }
+    template<typename T>
+    inline void Set(slot s, const T& value)
+    {
+        Set(T::ms_type, s, &value, sizeof(T));
+    }
+};
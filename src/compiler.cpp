@@ -118,15 +118,27 @@ static const TokenType ReservedTokens[] =
     TT_THIS,
     TT_TRUE,
 };
-static uint64_t ReservedHashes[NELEM(ReservedWords)];
-
-inline void InitReservedWords()
+static constexpr uint64_t ReservedHashes[] = 
 {
-    for(int32_t i = 0; i < NELEM(ReservedWords); ++i)
-    {
-        ReservedHashes[i] = Fnv64(ReservedWords[i]);
-    }
-}
+    "and"_h,
+    "struct"_h,
+    "else"_h,
+    "if"_h,
+    "nil"_h,
+    "or"_h,
+    "print"_h,
+    "return"_h,
+    "super"_h,
+    "var"_h,
+    "while"_h,
+    "false"_h,
+    "for"_h,
+    "fun"_h,
+    "this"_h,
+    "true"_h,
+};
+static_assert(NELEM(ReservedHashes) == NELEM(ReservedWords), "");
+static_assert(NELEM(ReservedTokens) == NELEM(ReservedWords), "");
 
 struct Scanner
 {
@@ -139,7 +151,6 @@ struct Scanner
     {
         MemZero(*this);
         src = source;
-        InitReservedWords();
     }
     inline Token MakeError(const char* msg) const 
     {
@@ -2,33 +2,120 @@
 
 #include "gen_array.h"
 #include "macro.h"
-#include "blockalloc.h"
+#include "archetype.h"
+#include "hashmap.h"
 
 #include "rendercomponent.h"
 #include "physics.h"
 
+// where an entity's components live
 struct Row
 {
-    void* m_components[CT_Count];
+    int32_t m_archetype;
+    int32_t m_row;
+};
 
-    template<typename T>
-    inline const T* Get() const
-    {
-        return static_cast<const T*>(m_components[T::ms_type]);
-    }
-    template<typename T>
-    inline T* Get()
-    {
-        return static_cast<T*>(m_components[T::ms_type]);
-    }
+// archetypes holding every type in a mask
+struct Query
+{
+    ComponentMask   m_mask;
+    Array<int32_t>  m_archetypes;
 };
+TRIVIALLY_RELOCATABLE(Query)
 
 namespace Components
 {
-    gen_array<Row>      ms_rows;
-    Array<slot>         ms_alive;
-    BlockAlloc          ms_allocs[CT_Count];
-    bool                ms_hasInit = false;
+    packed_gen_array<Row>               ms_rows;
+    Array<Archetype>                    ms_archetypes;
+    HashMap<ComponentMask, int32_t>     ms_archetypeLookup;
+    Array<Query>                        ms_queries;
+    HashMap<ComponentMask, int32_t>     ms_queryLookup;
+    uint32_t                            ms_sizes[CT_Count];
+    bool                                ms_hasInit = false;
+
+    int32_t FindArchetype(ComponentMask mask)
+    {
+        bool added;
+        int32_t& idx = ms_archetypeLookup.FindOrAdd(mask, added);
+        if(added)
+        {
+            idx = ms_archetypes.count();
+            ms_archetypes.grow().Init(mask, ms_sizes);
+            for(Query& query : ms_queries)
+            {
+                if((mask & query.m_mask) == query.m_mask)
+                {
+                    query.m_archetypes.grow() = idx;
+                }
+            }
+        }
+        return idx;
+    }
+    // index rather than reference; ms_queries grows as new masks are queried
+    int32_t FindQuery(ComponentMask mask)
+    {
+        bool added;
+        int32_t& idx = ms_queryLookup.FindOrAdd(mask, added);
+        if(added)
+        {
+            idx = ms_queries.count();
+            Query& query = ms_queries.grow();
+            query.m_mask = mask;
+            new (&query.m_archetypes) Array<int32_t>();
+            for(int32_t i = 0; i < ms_archetypes.count(); ++i)
+            {
+                if((ms_archetypes[i].m_mask & mask) == mask)
+                {
+                    query.m_archetypes.grow() = i;
+                }
+            }
+        }
+        return idx;
+    }
+    // follows the cached edge for adding or removing one type
+    int32_t Transition(int32_t from, ComponentType type, bool add)
+    {
+        int32_t* edges = add ? ms_archetypes[from].m_add : ms_archetypes[from].m_remove;
+        int32_t to = edges[type];
+        if(to == -1)
+        {
+            const ComponentMask mask = ms_archetypes[from].m_mask;
+            to = FindArchetype(add ? (mask | MaskOf(type)) : (mask & ~MaskOf(type)));
+            // FindArchetype may have grown ms_archetypes
+            edges = add ? ms_archetypes[from].m_add : ms_archetypes[from].m_remove;
+            edges[type] = to;
+        }
+        return to;
+    }
+    // drops a row from its archetype, pointing the row moved into its place back at it
+    void RemoveRow(const Row& row)
+    {
+        const slot moved = ms_archetypes[row.m_archetype].RemoveRow(row.m_row);
+        if(!slot::IsInvalid(moved))
+        {
+            ms_rows.GetUnchecked(moved).m_row = row.m_row;
+        }
+    }
+    // moves s to another archetype, carrying over the components both share
+    void Move(slot s, Row& row, int32_t to)
+    {
+        Archetype& dst = ms_archetypes[to];
+        const Archetype& src = ms_archetypes[row.m_archetype];
+        const int32_t dstRow = dst.AddRow(s);
+        for(int32_t t = 0; t < CT_Count; ++t)
+        {
+            const ComponentType type = (ComponentType)t;
+            void* dstItem = dst.Get(type, dstRow);
+            const void* srcItem = src.Get(type, row.m_row);
+            if(dstItem && srcItem)
+            {
+                memcpy(dstItem, srcItem, dst.m_sizes[t]);
+            }
+        }
+        RemoveRow(row);
+        row.m_archetype = to;
+        row.m_row = dstRow;
+    }
 
     void Init()
     {
@@ -37,18 +124,45 @@ namespace Components
             return;
         }
         ms_hasInit = true;
-        ms_allocs[CT_Render].Init<RenderComponent>();
-        ms_allocs[CT_Physics].Init<PhysicsComponent>();
+        MemZero(ms_sizes);
+        ms_sizes[CT_Render] = sizeof(RenderComponent);
+        ms_sizes[CT_Physics] = sizeof(PhysicsComponent);
+        // the empty archetype is always index 0
+        FindArchetype(0u);
     }
     slot Create()
     {
+        Init();
         slot s = ms_rows.Create();
-        ms_alive.grow() = s;
+        Row& row = ms_rows.GetUnchecked(s);
+        row.m_archetype = 0;
+        row.m_row = ms_archetypes[0].AddRow(s);
         return s;
     }
-    void CleanupPhysics(Row& row)
+    void CreateBatch(int32_t count, ComponentMask mask, slot* out)
     {
-        PhysicsComponent* pc = row.Get<PhysicsComponent>();
+        Init();
+        if(count <= 0)
+        {
+            return;
+        }
+        const int32_t idx = FindArchetype(mask);
+        ms_rows.Reserve(count);
+        for(int32_t i = 0; i < count; ++i)
+        {
+            out[i] = ms_rows.Create();
+        }
+        const int32_t first = ms_archetypes[idx].AddRows(out, count);
+        for(int32_t i = 0; i < count; ++i)
+        {
+            Row& row = ms_rows.GetUnchecked(out[i]);
+            row.m_archetype = idx;
+            row.m_row = first + i;
+        }
+    }
+    void CleanupPhysics(const Row& row)
+    {
+        PhysicsComponent* pc = (PhysicsComponent*)ms_archetypes[row.m_archetype].Get(CT_Physics, row.m_row);
         if(pc)
         {
             pc->Shutdown();
@@ -59,20 +173,36 @@ namespace Components
         if(ms_rows.Exists(s))
         {
             Row& row = ms_rows.GetUnchecked(s);
-
             CleanupPhysics(row);
-
-            for(int32_t i = 0; i < CT_Count; ++i)
+            RemoveRow(row);
+            ms_rows.DestroyUnchecked(s);
+        }
+    }
+    void DestroyBatch(const slot* slots, int32_t count)
+    {
+        TempScope scope;
+        btRigidBody** bodies = (btRigidBody**)Allocator::Alloc(AB_Temp, sizeof(btRigidBody*) * Max(count, 1));
+        int32_t bodyCount = 0;
+        for(int32_t i = 0; i < count; ++i)
+        {
+            const slot s = slots[i];
+            // also skips repeats, which are gone by their second visit
+            if(!ms_rows.Exists(s))
             {
-                if(row.m_components[i])
-                {
-                    ms_allocs[i].Free(row.m_components[i]);
-                    row.m_components[i] = nullptr;
-                }
+                continue;
             }
-
+            const Row& row = ms_rows.GetUnchecked(s);
+            const PhysicsComponent* pc = (const PhysicsComponent*)ms_archetypes[row.m_archetype].Get(CT_Physics, row.m_row);
+            if(pc && pc->m_body)
+            {
+                bodies[bodyCount++] = pc->m_body;
+            }
+            RemoveRow(row);
             ms_rows.DestroyUnchecked(s);
-            ms_alive.findRemove(s);
+        }
+        if(bodyCount)
+        {
+            Physics::DestroyBatch(bodies, bodyCount);
         }
     }
     void* Get(ComponentType type, slot s)
@@ -81,17 +211,12 @@ namespace Components
         {
             return nullptr;
         }
-        Row& row = ms_rows.GetUnchecked(s);
-        return row.m_components[type];
+        const Row& row = ms_rows.GetUnchecked(s);
+        return ms_archetypes[row.m_archetype].Get(type, row.m_row);
     }
     const void* GetConst(ComponentType type, slot s)
     {
-        if(!Exists(s))
-        {
-            return nullptr;
-        }
-        const Row& row = ms_rows.GetUnchecked(s);
-        return row.m_components[type];
+        return Get(type, s);
     }
     void Add(ComponentType type, slot s)
     {
@@ -100,10 +225,9 @@ namespace Components
             return;
         }
         Row& row = ms_rows.GetUnchecked(s);
-        void* c = row.m_components[type];
-        if(!c)
+        if(!ms_archetypes[row.m_archetype].Has(type))
         {
-            row.m_components[type] = ms_allocs[type].Alloc();
+            Move(s, row, Transition(row.m_archetype, type, true));
         }
     }
     void Remove(ComponentType type, slot s)
@@ -119,38 +243,52 @@ namespace Components
             CleanupPhysics(row);
         }
 
-        ms_allocs[type].Free(row.m_components[type]);
-        row.m_components[type] = nullptr;
+        Move(s, row, Transition(row.m_archetype, type, false));
     }
-    bool Exists(slot s) 
+    bool Exists(slot s)
     {
         return ms_rows.Exists(s);
     }
     bool Has(ComponentType type, slot s)
     {
-        return Exists(s) && (ms_rows.GetUnchecked(s).m_components[type] != nullptr);
+        return Exists(s) && ms_archetypes[ms_rows.GetUnchecked(s).m_archetype].Has(type);
     }
     void* GetAdd(ComponentType type, slot s)
     {
-        if(!Exists(s))
-        {
-            return nullptr;
-        }
-        Row& row = ms_rows.GetUnchecked(s);
-        void* c = row.m_components[type];
-        if(!c)
-        {
-            c = ms_allocs[type].Alloc();
-            row.m_components[type] = c;
-        }
-        return c;
+        Add(type, s);
+        return Get(type, s);
     }
     const slot* begin()
     {
-        return ms_alive.begin();
+        return ms_rows.slotsBegin();
     }
     const slot* end()
     {
-        return ms_alive.end();
+        return ms_rows.slotsEnd();
+    }
+    void ForEachChunk(ComponentMask mask, ChunkFn fn, void* data)
+    {
+        Init();
+        const int32_t query = FindQuery(mask);
+        // fn may run other queries, which can grow ms_queries; archetypes
+        // matched after this point aren't visited
+        const int32_t matches = ms_queries[query].m_archetypes.count();
+        ComponentChunk chunk;
+        for(int32_t i = 0; i < matches; ++i)
+        {
+            const int32_t idx = ms_queries[query].m_archetypes[i];
+            const int32_t chunks = ms_archetypes[idx].ChunkCount();
+            for(int32_t c = 0; c < chunks; ++c)
+            {
+                const Archetype& arch = ms_archetypes[idx];
+                chunk.slots = arch.Slots(c);
+                chunk.count = arch.RowsInChunk(c);
+                for(int32_t t = 0; t < CT_Count; ++t)
+                {
+                    chunk.columns[t] = arch.Column(c, (ComponentType)t);
+                }
+                fn(chunk, data);
+            }
+        }
     }
 };
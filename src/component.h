@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include "slot.h"
 
 enum ComponentType
@@ -16,11 +17,58 @@ enum ComponentType
     CT_Count  
 };
 
+typedef uint32_t ComponentMask;
+static_assert(CT_Count <= 32, "ComponentMask holds one bit per type");
+
+inline ComponentMask MaskOf(ComponentType type)
+{
+    return 1u << type;
+}
+
+template<typename... Ts>
+struct QueryMask;
+template<>
+struct QueryMask<>
+{
+    static constexpr ComponentMask value = 0u;
+};
+template<typename T, typename... Ts>
+struct QueryMask<T, Ts...>
+{
+    static constexpr ComponentMask value = (1u << T::ms_type) | QueryMask<Ts...>::value;
+};
+
+// a run of entities sharing one archetype chunk; column i of a type belongs
+// to slots[i]. columns of types the archetype lacks are nullptr.
+struct ComponentChunk
+{
+    const slot*     slots;
+    void*           columns[CT_Count];
+    int32_t         count;
+
+    template<typename T>
+    inline T* Column() const
+    {
+        return static_cast<T*>(columns[T::ms_type]);
+    }
+};
+
+typedef void (*ChunkFn)(const ComponentChunk& chunk, void* data);
+
+// entities with the same set of components share an archetype table with
+// one contiguous column per type. pointers from Get stay valid until a
+// component is added to or removed from that entity, or another entity in
+// the same archetype is destroyed.
 namespace Components
 {
     void Init();
     slot Create();
     void Destroy(slot s);
+    // creates count entities already holding every type in mask, writing
+    // their slots to out. components start zeroed.
+    void CreateBatch(int32_t count, ComponentMask mask, slot* out);
+    // destroys every live slot in the span; physics bodies go in one batch
+    void DestroyBatch(const slot* slots, int32_t count);
     void* Get(ComponentType type, slot s);
     const void* GetConst(ComponentType type, slot s);
     void Add(ComponentType type, slot s);
@@ -32,6 +80,35 @@ namespace Components
     const slot* begin();
     const slot* end();
 
+    // calls fn for every non-empty chunk whose archetype has all of mask.
+    // matching archetypes are cached per mask, so the walk never looks at
+    // entities without the full set. fn may run nested queries and use
+    // Get, but must not Create, Destroy, Add or Remove; record those with
+    // Commands and play them back after the walk.
+    void ForEachChunk(ComponentMask mask, ChunkFn fn, void* data);
+
+    // fn(int32_t count, const slot* slots, Ts*... columns)
+    template<typename... Ts, typename F>
+    inline void ForEachChunk(F fn)
+    {
+        ForEachChunk(QueryMask<Ts...>::value, [](const ComponentChunk& chunk, void* data)
+        {
+            (*static_cast<F*>(data))(chunk.count, chunk.slots, chunk.Column<Ts>()...);
+        }, &fn);
+    }
+    // fn(slot s, Ts&... components); same rules as ForEachChunk
+    template<typename... Ts, typename F>
+    inline void ForEach(F fn)
+    {
+        ForEachChunk<Ts...>([&fn](int32_t count, const slot* slots, Ts*... columns)
+        {
+            for(int32_t i = 0; i < count; ++i)
+            {
+                fn(slots[i], columns[i]...);
+            }
+        });
+    }
+
     template<typename T>
     inline T* Get(slot s)
     {
@@ -62,5 +139,10 @@ namespace Components
     {
         return static_cast<T*>(GetAdd(T::ms_type, s));
     }
+    template<typename... Ts>
+    inline void CreateBatch(int32_t count, slot* out)
+    {
+        CreateBatch(count, QueryMask<Ts...>::value, out);
+    }
 };
 
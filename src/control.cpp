@@ -1,6 +1,6 @@
 #include "control.h"
 #include "array.h"
-#include "fnv.h"
+#include "name.h"
 #include "window.h"
 
 #define GLFW_INCLUDE_NONE
@@ -22,11 +22,11 @@ namespace Control
     typedef FixedArray<ActionBinding, 16> ActionBindings;
     typedef FixedArray<AxisBinding, 8> AxisBindings;
 
-    static Array<ActionBindings> ms_actionBindings;
-    static Array<uint64_t>      ms_actionHashes;
+    static Array<ActionBindings, true, AB_Slab> ms_actionBindings;
+    static Array<NameId, true, AB_Slab>         ms_actionNames;
 
-    static Array<AxisBindings>  ms_axesBindings;
-    static Array<uint64_t>      ms_axesHashes;
+    static Array<AxisBindings, true, AB_Slab>   ms_axesBindings;
+    static Array<NameId, true, AB_Slab>         ms_axesNames;
 
     static float                ms_dt;
     static bool                 ms_cursorHidden = true;
@@ -54,9 +54,9 @@ namespace Control
         MemZero(ms_mouseButtons);
         MemZero(ms_gameButtons);
         ms_actionBindings.clear();
-        ms_actionHashes.clear();
+        ms_actionNames.clear();
         ms_axesBindings.clear();
-        ms_axesHashes.clear();
+        ms_axesNames.clear();
     }
     void Update(float dt)
     {
@@ -126,9 +126,9 @@ namespace Control
     void Shutdown()
     {
         ms_actionBindings.reset();
-        ms_actionHashes.reset();
+        ms_actionNames.reset();
         ms_axesBindings.reset();
-        ms_axesHashes.reset();
+        ms_axesNames.reset();
     }
 
     void SetCursorHidden(bool hidden)
@@ -236,20 +236,20 @@ namespace Control
 
     int32_t RegisterAction(const char* name)
     {
-        uint64_t hash = Fnv64(name);
-        int32_t idx = ms_actionHashes.find(hash);
+        const NameId id = Names::Intern(name);
+        int32_t idx = ms_actionNames.find(id);
         if(idx != -1)
         {
             return idx;
         }
-        idx = ms_actionHashes.count();
-        ms_actionHashes.grow() = hash;
+        idx = ms_actionNames.count();
+        ms_actionNames.grow() = id;
         MemZero(ms_actionBindings.grow());
         return idx;
     }
     int32_t GetActionLocation(const char* name)
     {
-        return ms_actionHashes.find(Fnv64(name));
+        return ms_actionNames.find(Names::Find(Fnv64(name)));
     }
     void BindToAction(int32_t location, ButtonLogic logic, Key key)
     {
@@ -350,20 +350,20 @@ namespace Control
 
     int32_t RegisterAxis(const char* name)
     {
-        uint64_t hash = Fnv64(name);
-        int32_t idx = ms_axesHashes.find(hash);
+        const NameId id = Names::Intern(name);
+        int32_t idx = ms_axesNames.find(id);
         if(idx != -1)
         {
             return idx;
         }
-        idx = ms_axesHashes.count();
-        ms_axesHashes.grow() = hash;
+        idx = ms_axesNames.count();
+        ms_axesNames.grow() = id;
         MemZero(ms_axesBindings.grow());
         return idx;
     }
     int32_t GetAxisLocation(const char* name)
     {
-        return ms_axesHashes.find(Fnv64(name));
+        return ms_axesNames.find(Names::Find(Fnv64(name)));
     }
     void BindToAxis(int32_t location, AxisLogic logic, MouseAxis axis)
     {
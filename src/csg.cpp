@@ -3,6 +3,7 @@
 #include "macro.h"
 #include "task.h"
 #include "sema.h"
+#include "appendbuffer.h"
 
 static const int32_t edgeTable[256] = 
 {
@@ -425,8 +426,7 @@ namespace CSGUtil
     {
         const CSG*      csgs;
         int32_t         count;
-        TempArray<Vertex>*    pOut;
-        std::mutex      outLock;
+        AppendBuffer<Vertex, true, AB_Temp>* pOut;
     };
 
     struct JobInstance
@@ -443,8 +443,7 @@ namespace CSGUtil
 
         const CSG*      csgs    = inst.shared->csgs;
         const int32_t   count   = inst.shared->count;
-        TempArray<Vertex>& out     = *(inst.shared->pOut);
-        std::mutex&     lock    = inst.shared->outLock;
+        AppendBuffer<Vertex, true, AB_Temp>& out = *(inst.shared->pOut);
         const float     radius  = inst.radius;
 
         float dis = CSGUtil::Map(inst.pt, csgs, count).distance;
@@ -474,18 +473,18 @@ namespace CSGUtil
 
         if(!tris.empty())
         {
-            LockGuard guard(lock);
-            out.expand(tris.count() * 3);
+            FixedArray<Vertex, 15> verts;
+            verts.clear();
             for(const Triangle& tri : tris)
             {
                 for(const vec3& pt : tri.p)
                 {
-                    Vertex v;
+                    Vertex& v = verts.grow();
                     v.position = pt;
                     v.normal = CSGUtil::Normal(pt, csgs, count);
-                    out.append() = v;
                 }
             }
+            out.Append(verts.begin(), verts.count());
         }
     }
 
@@ -497,12 +496,14 @@ namespace CSGUtil
         float           radius, 
         int32_t         dimension)
     {
-        out.clear();
+        // surface cells grow with the square of the dimension; anything past
+        // the estimate spills to the overflow array
+        AppendBuffer<Vertex, true, AB_Temp> sink(out, dimension * dimension * 8);
 
         JobShared shared;
         shared.csgs = csgs;
         shared.count = count;
-        shared.pOut = &out;
+        shared.pOut = &sink;
 
         const float pitch = 2.0f * radius / (float)dimension;
         const int32_t dim = dimension / 2;
@@ -525,5 +526,6 @@ namespace CSGUtil
         }
 
         TaskManager::Start(TT_MeshGen, 64);
+        sink.Finish();
     }
 };
@@ -45,7 +45,7 @@ struct Dict
     inline void Remove(K key)
     {
         Lane& lane = GetLane(key);
-        int32_t idx = lane[slot].findA(key);
+        int32_t idx = lane.findA(key);
         if(idx != -1)
         {
             lane.remove(idx);
@@ -79,11 +79,20 @@ struct Dict2
 
     Array<Lane, false, t_bucket> m_lanes;
     int32_t                      m_count = 0u;
+    // incremental mode: lanes below m_oldWidth and at or past m_cursor
+    // still hold entries placed with the old width
+    int32_t                      m_oldWidth = 0;
+    int32_t                      m_cursor = 0;
+    int32_t                      m_lanesPerStep = 0;
 
     inline bool NeedRehash() const 
     {
         return (m_lanes.count() == 0) || (m_count / 16 > m_lanes.count());
     }
+    inline bool Migrating() const
+    {
+        return m_oldWidth != 0;
+    }
     inline uint64_t Width() const 
     {
         return (uint64_t)m_lanes.count();
@@ -98,40 +107,130 @@ struct Dict2
         uint64_t slot = key % Width();
         return m_lanes[(int32_t)slot];
     }
-    void Rehash(int32_t size)
+    // growth moves lanesPerStep lanes per Insert or Remove instead of
+    // redistributing everything at once; 0 restores the blocking rehash
+    // and finishes any migration in flight
+    inline void SetIncremental(int32_t lanesPerStep)
     {
-        Array<Lane, false, t_bucket> newLanes;
-        newLanes.resize(size);
-        for(Lane& lane : m_lanes)
+        m_lanesPerStep = Max(lanesPerStep, 0);
+        if(!m_lanesPerStep && Migrating())
+        {
+            Migrate(m_oldWidth);
+        }
+    }
+    // moves the entries of lane i that don't belong there at width
+    void Redistribute(int32_t i, uint64_t width)
+    {
+        Lane& lane = m_lanes[i];
+        for(int32_t j = lane.count() - 1; j >= 0; --j)
         {
-            K* keys = lane.beginA();
-            V* data = lane.beginB();
-            for(int32_t i = 0; i < lane.count(); ++i)
+            const K key = lane.getA(j);
+            const int32_t slot = (int32_t)(key % width);
+            if(slot != i)
             {
-                Insert(newLanes, keys[i], data[i]);
+                Lane& dst = m_lanes[slot];
+                dst.grow();
+                dst.backA() = key;
+                Assume(dst.backB(), lane.getB(j));
+                lane.remove(j);
             }
         }
-        m_lanes.assume(newLanes);
     }
-    static inline void Insert(Array<Lane, false, t_bucket>& lanes, K key, V& item)
+    void Migrate(int32_t lanes)
     {
-        uint64_t slot = key % (uint64_t)lanes.count();
-        Lane& lane = lanes[(int32_t)slot];
-        lane.grow();
-        lane.backA() = key;
-        Assume(lane.backB(), item);
+        const int32_t end = Min(m_cursor + Max(lanes, 1), m_oldWidth);
+        for(; m_cursor < end; ++m_cursor)
+        {
+            Redistribute(m_cursor, Width());
+        }
+        if(m_cursor == m_oldWidth)
+        {
+            m_oldWidth = 0;
+            m_cursor = 0;
+        }
     }
-    inline void Insert(K key, const V& item)
+    // redistributes entries in place; the lane array grows via Realloc.
+    // when shrinking, entries move by the new width before the tail lanes
+    // are dropped.
+    void Rehash(int32_t size)
+    {
+        Assert(size > 0);
+        if(Migrating())
+        {
+            Migrate(m_oldWidth);
+        }
+        const int32_t oldSize = m_lanes.count();
+        if(size > oldSize)
+        {
+            m_lanes.resize(size);
+        }
+        for(int32_t i = 0; i < oldSize; ++i)
+        {
+            Redistribute(i, (uint64_t)size);
+        }
+        if(size < oldSize)
+        {
+            m_lanes.resize(size);
+        }
+    }
+    // grows the lane array now and leaves the old lanes to Migrate
+    void BeginRehash(int32_t size)
+    {
+        Assert(!Migrating());
+        const int32_t oldSize = m_lanes.count();
+        Assert(size > oldSize);
+        m_lanes.resize(size);
+        m_oldWidth = oldSize;
+        m_cursor = 0;
+    }
+    inline void Step()
+    {
+        if(Migrating())
+        {
+            Migrate(m_lanesPerStep);
+        }
+        else if(NeedRehash())
+        {
+            const int32_t size = m_lanes.count() ? m_lanes.count() * 2 : 1;
+            if(m_lanesPerStep > 0 && m_lanes.count())
+            {
+                BeginRehash(size);
+            }
+            else
+            {
+                Rehash(size);
+            }
+        }
+    }
+    // lane and index of key, or -1. checks the lane key had at the old
+    // width too while that lane is waiting to be migrated.
+    inline int32_t Find(K key, int32_t& slot) const
     {
-        if(NeedRehash())
+        if(!m_lanes.count())
+        {
+            return -1;
+        }
+        slot = (int32_t)(key % Width());
+        int32_t idx = m_lanes[slot].findA(key);
+        if(idx == -1 && Migrating())
         {
-            Rehash(m_lanes.count() ? m_lanes.count() * 2 : 1);
+            const int32_t old = (int32_t)(key % (uint64_t)m_oldWidth);
+            if(old >= m_cursor && old != slot)
+            {
+                slot = old;
+                idx = m_lanes[slot].findA(key);
+            }
         }
+        return idx;
+    }
+    inline void Insert(K key, const V& item)
+    {
+        Step();
 
-        Lane& lane = GetLane(key);
-        int32_t idx = lane.findA(key);
-        if(idx == -1)
+        int32_t slot;
+        if(Find(key, slot) == -1)
         {
+            Lane& lane = GetLane(key);
             lane.grow();
             lane.backA() = key;
             lane.backB() = item;
@@ -150,23 +249,27 @@ struct Dict2
     }
     inline V* Get(K key)
     {
-        Lane& lane = GetLane(key);
-        int32_t idx = lane.findA(key);
-        return idx == -1 ? nullptr : &(lane.getB(idx));
+        int32_t slot;
+        int32_t idx = Find(key, slot);
+        return idx == -1 ? nullptr : &(m_lanes[slot].getB(idx));
     }
     inline const V* Get(K key) const
     {
-        const Lane& lane = GetLane(key);
-        int32_t idx = lane.findA(key);
-        return idx == -1 ? nullptr : &(lane.getB(idx));
+        int32_t slot;
+        int32_t idx = Find(key, slot);
+        return idx == -1 ? nullptr : &(m_lanes[slot].getB(idx));
     }
     inline void Remove(K key)
     {
-        Lane& lane = GetLane(key);
-        int32_t idx = lane.findA(key);
+        if(Migrating())
+        {
+            Migrate(m_lanesPerStep);
+        }
+        int32_t slot;
+        int32_t idx = Find(key, slot);
         if(idx != -1)
         {
-            lane.remove(idx);
+            m_lanes[slot].remove(idx);
             --m_count;
         }
     }
@@ -181,3 +284,9 @@ using TempDict = Dict<K, V, width, AB_Temp>;
 
 template<typename K, typename V>
 using TempDict2 = Dict2<K, V, AB_Temp>;
+
+template<typename K, typename V, uint64_t width>
+using FrameDict = Dict<K, V, width, AB_Frame>;
+
+template<typename K, typename V>
+using FrameDict2 = Dict2<K, V, AB_Frame>;
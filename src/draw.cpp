@@ -10,6 +10,7 @@
 #include "prng.h"
 #include "renderer.h"
 #include "imgui.h"
+#include "allocator.h"
 
 mat4                VP;
 Textured::VSUniform vsuni;
@@ -91,6 +92,78 @@ inline void DrawFlat(const RenderComponent* rc)
     }
 }
 
+inline void DrawComponent(slot s, const RenderComponent& rc)
+{
+    switch(rc.m_type)
+    {
+        case PT_Textured:
+            DrawTextured(&rc);
+        break;
+        case PT_Flat:
+            DrawFlat(&rc);
+        break;
+    }
+}
+
+void DrawMemoryStats()
+{
+    ImGui::SetNextWindowSize(ImVec2(400.0f, 600.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos(ImVec2(810.0f, 0.0f), ImGuiCond_FirstUseEver);
+    if(ImGui::Begin("Memory"))
+    {
+        const AllocStats& stats = Allocator::GetFrameStats();
+        ImGui::Text("Temp peak: %.2f MB", stats.tempPeak / (1024.0f * 1024.0f));
+        ImGui::Text("Temp high water: %.2f MB", stats.tempHighWater / (1024.0f * 1024.0f));
+        ImGui::Text("Frame peak: %.2f MB", stats.framePeak / (1024.0f * 1024.0f));
+    #if ALLOC_TELEMETRY
+        ImGui::Separator();
+        ImGui::Columns(4);
+        ImGui::Text("Bucket");  ImGui::NextColumn();
+        ImGui::Text("Allocs");  ImGui::NextColumn();
+        ImGui::Text("Frees");   ImGui::NextColumn();
+        ImGui::Text("KB");      ImGui::NextColumn();
+        for(int32_t i = 0; i < AB_Count; ++i)
+        {
+            ImGui::Text("%s", Allocator::GetBucketName((AllocBucket)i));        ImGui::NextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.allocs[i]);           ImGui::NextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.frees[i]);            ImGui::NextColumn();
+            ImGui::Text("%.1f", stats.bytes[i] / 1024.0f);                     ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+        ImGui::Separator();
+
+        AllocSite sites[32];
+        const int32_t count = Allocator::GetTopSites(sites, NELEM(sites));
+        ImGui::Columns(3);
+        ImGui::Text("Site");    ImGui::NextColumn();
+        ImGui::Text("KB");      ImGui::NextColumn();
+        ImGui::Text("Count");   ImGui::NextColumn();
+        for(int32_t i = 0; i < count; ++i)
+        {
+            if(sites[i].tag)
+            {
+                ImGui::Text("%s", sites[i].tag);
+            }
+            else
+            {
+                ImGui::Text("%p", sites[i].address);
+            }
+            ImGui::NextColumn();
+            ImGui::Text("%.1f", sites[i].bytes / 1024.0f);                      ImGui::NextColumn();
+            ImGui::Text("%llu", (unsigned long long)sites[i].count);            ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+    #else
+        ImGui::Text("Set ALLOC_TELEMETRY in macro.h for bucket and call site counters");
+    #endif // ALLOC_TELEMETRY
+        if(ImGui::Button("Dump"))
+        {
+            Allocator::DumpStats("alloc_stats.txt");
+        }
+    }
+    ImGui::End();
+}
+
 void FirstDraw()
 {
 
@@ -124,6 +197,7 @@ void Draw()
         ImGui::SliderFloat("Metalness",         &fsuni.MetalnessOffset, -1.0f, 1.0f);
         ImGui::End();
     }
+    DrawMemoryStats();
 
     fsuni.Eye = cam->m_eye;
     flatfsuni.Albedo = fsuni.Pal0;
@@ -136,21 +210,7 @@ void Draw()
     Renderer::Begin();
     if(1)
     {
-        for(const slot* s = Components::begin(); s != Components::end(); ++s)
-        {
-            if(const RenderComponent* rc = Components::Get<RenderComponent>(*s))
-            {
-                switch(rc->m_type)
-                {
-                    case PT_Textured:
-                        DrawTextured(rc);
-                    break;
-                    case PT_Flat:
-                        DrawFlat(rc);
-                    break;
-                }
-            }
-        }
+        Components::ForEach<RenderComponent>(DrawComponent);
         Renderer::DrawBackground();
     }
     else 
@@ -163,21 +223,7 @@ void Draw()
             mat4 view = glm::lookAt(cam->m_eye, cam->m_eye - debugOrthoScale * debugDirs[i], debugUps[i]);
             VP = perspective * view;
             bgCam.V = view;
-            for(const slot* s = Components::begin(); s != Components::end(); ++s)
-            {
-                if(const RenderComponent* rc = Components::Get<RenderComponent>(*s))
-                {
-                    switch(rc->m_type)
-                    {
-                        case PT_Textured:
-                            DrawTextured(rc);
-                        break;
-                        case PT_Flat:
-                            DrawFlat(rc);
-                        break;
-                    }
-                }
-            }
+            Components::ForEach<RenderComponent>(DrawComponent);
             PushCamera pushCam(&bgCam);
             Renderer::DrawBackground();
         }
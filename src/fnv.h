@@ -1,13 +1,19 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif // _MSC_VER
 
 inline uint32_t Fnv32(const char* x)
 {
     uint32_t y = 2166136261u;
     while(*x)
     {
-        y ^= *x;
+        y ^= (uint8_t)*x;
         y *= 16777619u;
         ++x;
     }
@@ -31,7 +37,7 @@ inline uint64_t Fnv64(const char* x)
     uint64_t y = 14695981039346656037ull;
     while(*x)
     {
-        y ^= *x;
+        y ^= (uint8_t)*x;
         y *= 1099511628211ull;
         ++x;
     }
@@ -49,3 +55,168 @@ inline uint64_t Fnv64(const void* x, uint32_t len)
     }
     return y;
 }
+
+// compile time variants; match Fnv32/Fnv64 on the same string. every
+// variant hashes bytes as uint8_t, since char sign extends on most targets
+// and would give non-ascii names a different hash than the (ptr, len) form.
+constexpr uint32_t Fnv32Const(const char* x, uint32_t y = 2166136261u)
+{
+    return *x ? Fnv32Const(x + 1, (y ^ (uint8_t)*x) * 16777619u) : y;
+}
+
+constexpr uint64_t Fnv64Const(const char* x, uint64_t y = 14695981039346656037ull)
+{
+    return *x ? Fnv64Const(x + 1, (y ^ (uint8_t)*x) * 1099511628211ull) : y;
+}
+
+// "name"_h == Fnv64("name"), folded at compile time
+constexpr uint64_t operator"" _h(const char* x, size_t len)
+{
+    return Fnv64Const(x);
+}
+
+// utf-8 e-acute; walking signed chars would give 0x080d7307b4cc3001
+static_assert("\xc3\xa9"_h == 0x0ac21707b7181e01ull, "_h must hash bytes as uint8_t");
+static_assert(Fnv32Const("\xc3\xa9") == 0x1e9de8c1u, "Fnv32Const must hash bytes as uint8_t");
+
+// word at a time hash in the style of wyhash: 48 byte blocks across three
+// lanes, each folding 16 bytes with a 64x64->128 multiply. much faster than
+// fnv past a few bytes; not stable across versions, don't persist it.
+namespace WyHash
+{
+    static constexpr uint64_t P0 = 0xa0761d6478bd642full;
+    static constexpr uint64_t P1 = 0xe7037ed1a0b428dbull;
+    static constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+    static constexpr uint64_t P3 = 0x589965cc75374cc3ull;
+    static constexpr uint32_t BlockSize = 48u;
+
+    inline uint64_t Mix(uint64_t a, uint64_t b)
+    {
+    #ifdef _MSC_VER
+        uint64_t hi;
+        const uint64_t lo = _umul128(a, b, &hi);
+        return lo ^ hi;
+    #else
+        const __uint128_t r = (__uint128_t)a * b;
+        return (uint64_t)r ^ (uint64_t)(r >> 64);
+    #endif // _MSC_VER
+    }
+    inline uint64_t Read64(const uint8_t* p)
+    {
+        uint64_t x;
+        memcpy(&x, p, sizeof(x));
+        return x;
+    }
+    inline uint64_t Read32(const uint8_t* p)
+    {
+        uint32_t x;
+        memcpy(&x, p, sizeof(x));
+        return x;
+    }
+    inline uint64_t Seed(uint64_t seed)
+    {
+        return seed ^ Mix(seed ^ P0, P1);
+    }
+    inline void Block(uint64_t* lanes, const uint8_t* p)
+    {
+        lanes[0] = Mix(Read64(p +  0) ^ P1, Read64(p +  8) ^ lanes[0]);
+        lanes[1] = Mix(Read64(p + 16) ^ P2, Read64(p + 24) ^ lanes[1]);
+        lanes[2] = Mix(Read64(p + 32) ^ P3, Read64(p + 40) ^ lanes[2]);
+    }
+    // folds the last 0 to 48 bytes and the total length
+    inline uint64_t Finish(const uint64_t* lanes, const uint8_t* p, uint32_t len, uint64_t total)
+    {
+        uint64_t seed = lanes[0] ^ lanes[1] ^ lanes[2];
+        while(len > 16u)
+        {
+            seed = Mix(Read64(p) ^ P1, Read64(p + 8) ^ seed);
+            p += 16;
+            len -= 16u;
+        }
+        uint64_t a = 0u;
+        uint64_t b = 0u;
+        if(len >= 4u)
+        {
+            const uint32_t step = (len >> 3) << 2;
+            a = (Read32(p) << 32) | Read32(p + step);
+            b = (Read32(p + len - 4) << 32) | Read32(p + len - 4 - step);
+        }
+        else if(len > 0u)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+        }
+        return Mix(P1 ^ total, Mix(a ^ P1, b ^ seed));
+    }
+};
+
+inline uint64_t Hash64(const void* x, size_t len, uint64_t seed = 0u)
+{
+    const uint8_t* p = (const uint8_t*)x;
+    uint64_t lanes[3];
+    lanes[0] = lanes[1] = lanes[2] = WyHash::Seed(seed);
+    size_t left = len;
+    for(; left > WyHash::BlockSize; left -= WyHash::BlockSize, p += WyHash::BlockSize)
+    {
+        WyHash::Block(lanes, p);
+    }
+    return WyHash::Finish(lanes, p, (uint32_t)left, len);
+}
+
+// for small fixed size keys; the length folds away when inlined
+template<typename T>
+inline uint64_t HashPod(const T& x, uint64_t seed = 0u)
+{
+    return Hash64(&x, sizeof(T), seed);
+}
+
+// incremental Hash64; the result matches hashing the concatenated input
+struct HashStream
+{
+    uint64_t    m_lanes[3];
+    uint64_t    m_total;
+    uint8_t     m_buffer[WyHash::BlockSize];
+    uint32_t    m_buffered;
+
+    inline explicit HashStream(uint64_t seed = 0u)
+    {
+        m_lanes[0] = m_lanes[1] = m_lanes[2] = WyHash::Seed(seed);
+        m_total = 0u;
+        m_buffered = 0u;
+    }
+    inline void Update(const void* x, size_t len)
+    {
+        const uint8_t* p = (const uint8_t*)x;
+        m_total += len;
+        // a block is only consumed once more input follows it
+        if(m_buffered + len <= WyHash::BlockSize)
+        {
+            memcpy(m_buffer + m_buffered, p, len);
+            m_buffered += (uint32_t)len;
+            return;
+        }
+        if(m_buffered)
+        {
+            const uint32_t fill = WyHash::BlockSize - m_buffered;
+            memcpy(m_buffer + m_buffered, p, fill);
+            WyHash::Block(m_lanes, m_buffer);
+            p += fill;
+            len -= fill;
+            m_buffered = 0u;
+        }
+        for(; len > WyHash::BlockSize; len -= WyHash::BlockSize, p += WyHash::BlockSize)
+        {
+            WyHash::Block(m_lanes, p);
+        }
+        memcpy(m_buffer, p, len);
+        m_buffered = (uint32_t)len;
+    }
+    template<typename T>
+    inline void UpdatePod(const T& x)
+    {
+        Update(&x, sizeof(T));
+    }
+    inline uint64_t Final() const
+    {
+        return WyHash::Finish(m_lanes, m_buffer, m_buffered, m_total);
+    }
+};
@@ -78,3 +78,122 @@ struct gen_array
         return s.id < (uint32_t)m_data.count() && m_gen[s.id] == s.gen; 
     }
 };
+
+// sparse set flavour of gen_array: live values stay packed at the front of
+// m_data, so begin()/end() walk them linearly. m_index maps a slot id to its
+// packed position and m_slots maps back; Destroy moves the last value into
+// the hole, so pointers and packed indices are only stable until then.
+template<typename T, bool POD = true, AllocBucket t_bucket = AB_Default>
+struct packed_gen_array
+{
+    Array<T, POD, t_bucket> m_data;
+    Array<slot>             m_slots;
+    Array<int32_t>          m_index;
+    Array<int32_t>          m_gen;
+    Array<int32_t>          m_free;
+
+    void Reset()
+    {
+        m_data.reset();
+        m_slots.reset();
+        m_index.reset();
+        m_gen.reset();
+        m_free.reset();
+    }
+    // room for count more live values without regrowing
+    void Reserve(int32_t count)
+    {
+        m_data.reserve(m_data.count() + count);
+        m_slots.reserve(m_slots.count() + count);
+        const int32_t fresh = count - m_free.count();
+        if(fresh > 0)
+        {
+            m_index.reserve(m_index.count() + fresh);
+            m_gen.reserve(m_gen.count() + fresh);
+            m_free.reserve(m_free.count() + fresh);
+        }
+    }
+    slot Create()
+    {
+        if(m_free.empty())
+        {
+            m_free.grow() = m_gen.count();
+            m_gen.grow() = 0;
+            m_index.grow() = -1;
+        }
+
+        slot s;
+        s.id = m_free.back();
+        m_free.pop();
+        s.gen = m_gen[s.id];
+
+        m_index[s.id] = m_data.count();
+        m_slots.grow() = s;
+        memset(&m_data.grow(), 0, sizeof(T));
+
+        return s;
+    }
+    inline T* Get(slot s)
+    {
+        if(!Exists(s))
+        {
+            return nullptr;
+        }
+        return &GetUnchecked(s);
+    }
+    inline const T* Get(slot s) const
+    {
+        if(!Exists(s))
+        {
+            return nullptr;
+        }
+        return &GetUnchecked(s);
+    }
+    // for when you check Exists() first and layer behavior above this
+    inline T& GetUnchecked(slot s)
+    {
+        return m_data[m_index[s.id]];
+    }
+    inline const T& GetUnchecked(slot s) const
+    {
+        return m_data[m_index[s.id]];
+    }
+    inline void Destroy(slot s)
+    {
+        if(!Exists(s))
+        {
+            return;
+        }
+        DestroyUnchecked(s);
+    }
+    // for when you check Exists() first and layer behavior above this
+    inline void DestroyUnchecked(slot s)
+    {
+        const int32_t idx = m_index[s.id];
+        m_data.remove(idx);
+        m_slots.remove(idx);
+        if(idx < m_slots.count())
+        {
+            m_index[m_slots[idx].id] = idx;
+        }
+        m_index[s.id] = -1;
+        m_gen[s.id]++;
+        m_free.grow() = s.id;
+    }
+    inline bool Exists(slot s) const
+    {
+        return s.id < (uint32_t)m_gen.count() && m_gen[s.id] == s.gen; 
+    }
+    inline int32_t Count() const
+    {
+        return m_data.count();
+    }
+    // live values in packed order
+    inline T* begin()                           { return m_data.begin(); }
+    inline T* end()                             { return m_data.end(); }
+    inline const T* begin()             const   { return m_data.begin(); }
+    inline const T* end()               const   { return m_data.end(); }
+    // slot of each live value, parallel to begin()/end()
+    inline const slot* slotsBegin()     const   { return m_slots.begin(); }
+    inline const slot* slotsEnd()       const   { return m_slots.end(); }
+};
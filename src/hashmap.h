@@ -0,0 +1,387 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+
+#include "macro.h"
+#include "allocator.h"
+#include "array.h"
+#include "fnv.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define HASHMAP_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define HASHMAP_SSE2 0
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif // _MSC_VER
+
+// hashers; HashMap uses the high bits to pick a group and the low 7 as a tag
+struct MixHash
+{
+    template<typename K>
+    inline uint64_t operator()(const K& key) const
+    {
+        uint64_t h = (uint64_t)key;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+// for keys that are already well distributed hashes
+struct IdentityHash
+{
+    template<typename K>
+    inline uint64_t operator()(const K& key) const
+    {
+        return (uint64_t)key;
+    }
+};
+
+struct BytesHash
+{
+    template<typename K>
+    inline uint64_t operator()(const K& key) const
+    {
+        return HashPod(key);
+    }
+};
+
+inline int32_t CountTrailingZeros(uint32_t x)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, x);
+    return (int32_t)idx;
+#else
+    return __builtin_ctz(x);
+#endif // _MSC_VER
+}
+
+// flat open addressing table in the style of SwissTable. each slot has a
+// control byte holding empty, deleted or 7 bits of the key's hash; lookups
+// compare a group of 16 control bytes at once and only touch the slots whose
+// tag matches. the first group's bytes are mirrored past the end so a group
+// can be loaded at any position. keys and values move with memcpy on rehash.
+template<typename K, typename V, typename Hasher = MixHash, AllocBucket t_bucket = AB_Default>
+struct HashMap
+{
+    static_assert(TriviallyRelocatable<K>::value && TriviallyRelocatable<V>::value,
+        "HashMap relocates slots with memcpy");
+
+    static constexpr int32_t GroupWidth = 16;
+    static constexpr int8_t  Empty      = -128;
+    static constexpr int8_t  Deleted    = -2;
+
+    struct Slot
+    {
+        K key;
+        V value;
+    };
+
+    struct Group
+    {
+    #if HASHMAP_SSE2
+        __m128i m_ctrl;
+
+        inline explicit Group(const int8_t* ctrl)
+        {
+            m_ctrl = _mm_loadu_si128((const __m128i*)ctrl);
+        }
+        inline uint32_t Match(int8_t tag) const
+        {
+            return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), m_ctrl));
+        }
+        // empty and deleted are the only control bytes with the sign bit set
+        inline uint32_t MatchEmptyOrDeleted() const
+        {
+            return (uint32_t)_mm_movemask_epi8(m_ctrl);
+        }
+    #else
+        const int8_t* m_ctrl;
+
+        inline explicit Group(const int8_t* ctrl)
+        {
+            m_ctrl = ctrl;
+        }
+        inline uint32_t Match(int8_t tag) const
+        {
+            uint32_t mask = 0u;
+            for(int32_t i = 0; i < GroupWidth; ++i)
+            {
+                mask |= (uint32_t)(m_ctrl[i] == tag) << i;
+            }
+            return mask;
+        }
+        inline uint32_t MatchEmptyOrDeleted() const
+        {
+            uint32_t mask = 0u;
+            for(int32_t i = 0; i < GroupWidth; ++i)
+            {
+                mask |= (uint32_t)(m_ctrl[i] < 0) << i;
+            }
+            return mask;
+        }
+    #endif // HASHMAP_SSE2
+        inline uint32_t MatchEmpty() const
+        {
+            return Match(Empty);
+        }
+    };
+
+    int8_t*     m_ctrl;
+    Slot*       m_slots;
+    int32_t     m_capacity;
+    int32_t     m_count;
+    int32_t     m_growthLeft;
+
+    inline HashMap()
+    {
+        MemZero(*this);
+    }
+    ~HashMap()
+    {
+        Reset();
+    }
+    HashMap(const HashMap&) = delete;
+    HashMap& operator=(const HashMap&) = delete;
+    inline HashMap(HashMap&& other) noexcept
+    {
+        Assume(*this, other);
+    }
+    inline HashMap& operator=(HashMap&& other) noexcept
+    {
+        Reset();
+        Assume(*this, other);
+        return *this;
+    }
+
+    inline int32_t Count() const
+    {
+        return m_count;
+    }
+    inline int32_t Capacity() const
+    {
+        return m_capacity;
+    }
+    static inline int32_t MaxLoad(int32_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+    static inline uint64_t Hash(const K& key)
+    {
+        return Hasher()(key);
+    }
+    static inline int8_t Tag(uint64_t hash)
+    {
+        return (int8_t)(hash & 0x7f);
+    }
+    inline void SetCtrl(int32_t i, int8_t c)
+    {
+        m_ctrl[i] = c;
+        if(i < GroupWidth)
+        {
+            m_ctrl[m_capacity + i] = c;
+        }
+    }
+    inline int32_t Find(const K& key, uint64_t hash) const
+    {
+        if(!m_capacity)
+        {
+            return -1;
+        }
+        const uint32_t mask = (uint32_t)m_capacity - 1u;
+        const int8_t tag = Tag(hash);
+        uint32_t pos = (uint32_t)(hash >> 7) & mask;
+        for(uint32_t step = GroupWidth; ; step += GroupWidth)
+        {
+            Group group(m_ctrl + pos);
+            for(uint32_t bits = group.Match(tag); bits; bits &= bits - 1u)
+            {
+                const uint32_t i = (pos + CountTrailingZeros(bits)) & mask;
+                if(m_slots[i].key == key)
+                {
+                    return (int32_t)i;
+                }
+            }
+            if(group.MatchEmpty())
+            {
+                return -1;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+    inline int32_t FindFree(uint64_t hash) const
+    {
+        const uint32_t mask = (uint32_t)m_capacity - 1u;
+        uint32_t pos = (uint32_t)(hash >> 7) & mask;
+        for(uint32_t step = GroupWidth; ; step += GroupWidth)
+        {
+            const uint32_t bits = Group(m_ctrl + pos).MatchEmptyOrDeleted();
+            if(bits)
+            {
+                return (int32_t)((pos + CountTrailingZeros(bits)) & mask);
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+    // capacity is a power of two of at least one group
+    void Rehash(int32_t capacity)
+    {
+        Assert(capacity >= GroupWidth && (capacity & (capacity - 1)) == 0);
+        Assert(MaxLoad(capacity) >= m_count);
+
+        int8_t* oldCtrl = m_ctrl;
+        Slot* oldSlots = m_slots;
+        const int32_t oldCapacity = m_capacity;
+
+        const size_t ctrlBytes = (capacity + GroupWidth + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+        uint8_t* block = (uint8_t*)Allocator::Alloc(t_bucket, ctrlBytes + sizeof(Slot) * capacity);
+        m_ctrl = (int8_t*)block;
+        m_slots = (Slot*)(block + ctrlBytes);
+        m_capacity = capacity;
+        m_growthLeft = MaxLoad(capacity) - m_count;
+        memset(m_ctrl, Empty, capacity + GroupWidth);
+
+        for(int32_t i = 0; i < oldCapacity; ++i)
+        {
+            if(oldCtrl[i] >= 0)
+            {
+                const uint64_t hash = Hash(oldSlots[i].key);
+                const int32_t j = FindFree(hash);
+                SetCtrl(j, Tag(hash));
+                memcpy(m_slots + j, oldSlots + i, sizeof(Slot));
+            }
+        }
+        Allocator::Free(t_bucket, oldCtrl);
+    }
+    // sizes the table to hold count entries without growing
+    inline void Reserve(int32_t count)
+    {
+        int32_t capacity = Max(m_capacity, GroupWidth);
+        while(MaxLoad(capacity) < count)
+        {
+            capacity *= 2;
+        }
+        if(capacity != m_capacity)
+        {
+            Rehash(capacity);
+        }
+    }
+    // returns the slot for key, adding a default constructed value if missing
+    inline V& FindOrAdd(const K& key, bool& added)
+    {
+        const uint64_t hash = Hash(key);
+        int32_t i = Find(key, hash);
+        added = i == -1;
+        if(added)
+        {
+            if(!m_capacity)
+            {
+                Rehash(GroupWidth);
+            }
+            else if(m_growthLeft == 0)
+            {
+                // reclaim tombstones in place when they are most of the load
+                Rehash(m_count * 2 < MaxLoad(m_capacity) ? m_capacity : m_capacity * 2);
+            }
+            i = FindFree(hash);
+            if(m_ctrl[i] == Empty)
+            {
+                --m_growthLeft;
+            }
+            SetCtrl(i, Tag(hash));
+            new (&m_slots[i].key) K(key);
+            new (&m_slots[i].value) V();
+            ++m_count;
+        }
+        return m_slots[i].value;
+    }
+    // keeps the existing value if key is already present, like Dict2
+    inline void Insert(const K& key, const V& item)
+    {
+        bool added;
+        V& value = FindOrAdd(key, added);
+        if(added)
+        {
+            value = item;
+        }
+    }
+    inline V& operator[](const K& key)
+    {
+        bool added;
+        return FindOrAdd(key, added);
+    }
+    inline V* Get(const K& key)
+    {
+        const int32_t i = Find(key, Hash(key));
+        return i == -1 ? nullptr : &m_slots[i].value;
+    }
+    inline const V* Get(const K& key) const
+    {
+        const int32_t i = Find(key, Hash(key));
+        return i == -1 ? nullptr : &m_slots[i].value;
+    }
+    inline bool Remove(const K& key)
+    {
+        const int32_t i = Find(key, Hash(key));
+        if(i == -1)
+        {
+            return false;
+        }
+        m_slots[i].key.~K();
+        m_slots[i].value.~V();
+        SetCtrl(i, Deleted);
+        --m_count;
+        return true;
+    }
+    inline void Clear()
+    {
+        for(int32_t i = 0; i < m_capacity; ++i)
+        {
+            if(m_ctrl[i] >= 0)
+            {
+                m_slots[i].key.~K();
+                m_slots[i].value.~V();
+            }
+        }
+        if(m_capacity)
+        {
+            memset(m_ctrl, Empty, m_capacity + GroupWidth);
+        }
+        m_count = 0;
+        m_growthLeft = MaxLoad(m_capacity);
+    }
+    inline void Reset()
+    {
+        Clear();
+        Allocator::Free(t_bucket, m_ctrl);
+        MemZero(*this);
+    }
+    template<typename T>
+    inline void ForEach(T fn)
+    {
+        for(int32_t i = 0; i < m_capacity; ++i)
+        {
+            if(m_ctrl[i] >= 0)
+            {
+                fn(m_slots[i].key, m_slots[i].value);
+            }
+        }
+    }
+};
+
+template<typename K, typename V, typename Hasher = MixHash>
+using TempHashMap = HashMap<K, V, Hasher, AB_Temp>;
+
+template<typename K, typename V, typename Hasher = MixHash>
+using FrameHashMap = HashMap<K, V, Hasher, AB_Frame>;
@@ -102,8 +102,10 @@ void Init()
 
     {
         slot ent = Components::Create();
-        RenderComponent* rc = Components::GetAdd<RenderComponent>(ent);
-        PhysicsComponent* pc = Components::GetAdd<PhysicsComponent>(ent);
+        Components::Add<RenderComponent>(ent);
+        Components::Add<PhysicsComponent>(ent);
+        RenderComponent* rc = Components::Get<RenderComponent>(ent);
+        PhysicsComponent* pc = Components::Get<PhysicsComponent>(ent);
 
         pc->Init(0.0f, vec3(0.0f, 0.0f, 0.0f), vec3(10.0f, 0.33f, 10.0f));
 
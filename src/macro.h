@@ -3,6 +3,8 @@
 #define PLM_ENABLE      0
 #define ASSERT_TYPE     1
 #define DEBUG_GL        0
+#define ALLOC_TELEMETRY 0
+#define TEMP_DEBUG      0
 #define MAX_PATH_LEN    256
 
 #define NELEM(x) ( sizeof(x) / (sizeof((x)[0])) )
@@ -0,0 +1,60 @@
+#include "name.h"
+
+#include <string.h>
+#include "macro.h"
+#include "array.h"
+#include "hashmap.h"
+#include "sema.h"
+
+namespace Names
+{
+    // strings are copied into the slab and never freed
+    static HashMap<uint64_t, NameId, IdentityHash>  ms_lookup;
+    static Array<const char*>                       ms_strings;
+    static std::mutex                               ms_lock;
+
+    NameId Intern(const char* name, int32_t len)
+    {
+        const uint64_t hash = Fnv64(name, (uint32_t)len);
+
+        LockGuard guard(ms_lock);
+        if(ms_strings.empty())
+        {
+            ms_strings.grow() = "";
+        }
+        bool added;
+        NameId& id = ms_lookup.FindOrAdd(hash, added);
+        if(added)
+        {
+            char* str = (char*)Allocator::Alloc(AB_Slab, len + 1);
+            memcpy(str, name, len);
+            str[len] = 0;
+            id = (NameId)ms_strings.count();
+            ms_strings.grow() = str;
+        }
+        // a 64 bit collision between two names
+        Assert(strncmp(ms_strings[id], name, len) == 0 && ms_strings[id][len] == 0);
+        return id;
+    }
+    NameId Intern(const char* name)
+    {
+        return Intern(name, (int32_t)strlen(name));
+    }
+    NameId Find(uint64_t hash)
+    {
+        LockGuard guard(ms_lock);
+        const NameId* id = ms_lookup.Get(hash);
+        return id ? *id : 0;
+    }
+    const char* GetString(NameId id)
+    {
+        LockGuard guard(ms_lock);
+        Assert(id < (NameId)ms_strings.count());
+        return ms_strings[id];
+    }
+    int32_t Count()
+    {
+        LockGuard guard(ms_lock);
+        return Max(ms_strings.count() - 1, 0);
+    }
+};
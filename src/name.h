@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include "fnv.h"
+
+// interned string id; dense, starting at 1, valid for the life of the
+// program. 0 is no name.
+typedef uint32_t NameId;
+
+// global string interner, safe to call from any thread
+namespace Names
+{
+    NameId Intern(const char* name);
+    NameId Intern(const char* name, int32_t len);
+    // id of an already interned name by its Fnv64 hash, eg. "MVP"_h; 0 if unknown
+    NameId Find(uint64_t hash);
+    const char* GetString(NameId id);
+    int32_t Count();
+};
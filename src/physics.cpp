@@ -4,43 +4,72 @@
 #include "gen_array.h"
 #include "blockalloc.h"
 #include "rendercomponent.h"
+#include "system.h"
 
 btDefaultCollisionConfiguration     ms_collisionConfig;
 btCollisionDispatcher               ms_dispatcher = btCollisionDispatcher(
                                         &ms_collisionConfig);
 btDbvtBroadphase                    ms_broadphase;
 btSequentialImpulseConstraintSolver ms_solver;
-btDiscreteDynamicsWorld             ms_world = btDiscreteDynamicsWorld(
+// btDiscreteDynamicsWorld::removeRigidBody does a linear search of the
+// dynamic body list per call; RemoveBodies filters that list once instead
+struct PhysicsWorld : public btDiscreteDynamicsWorld
+{
+    using btDiscreteDynamicsWorld::btDiscreteDynamicsWorld;
+
+    void RemoveBodies(btRigidBody* const* bodies, int32_t count)
+    {
+        for(int32_t i = 0; i < count; ++i)
+        {
+            // O(1) swap out of the collision object list, leaves the index at -1
+            btCollisionWorld::removeCollisionObject(bodies[i]);
+        }
+        int32_t kept = 0;
+        for(int32_t i = 0; i < m_nonStaticRigidBodies.size(); ++i)
+        {
+            btRigidBody* body = m_nonStaticRigidBodies[i];
+            if(body->getWorldArrayIndex() != -1)
+            {
+                m_nonStaticRigidBodies[kept++] = body;
+            }
+        }
+        m_nonStaticRigidBodies.resize(kept);
+    }
+};
+
+PhysicsWorld                        ms_world(
                                         &ms_dispatcher, 
                                         &ms_broadphase, 
                                         &ms_solver, 
                                         &ms_collisionConfig);
 
-TBlockAlloc<btBoxShape>             ms_shapes;
-TBlockAlloc<btRigidBody>            ms_bodies;
-TBlockAlloc<btDefaultMotionState>   ms_motionStates;
+TBlockAlloc<btBoxShape, 8, false>            ms_shapes;
+TBlockAlloc<btRigidBody, 8, false>           ms_bodies;
+TBlockAlloc<btDefaultMotionState, 8, false>  ms_motionStates;
 
 namespace Physics
 {
+    // copies simulated transforms to render components, run by Systems::Update
+    void SyncTransforms(const ComponentChunk& chunk, float dt)
+    {
+        const PhysicsComponent* pcs = chunk.Column<PhysicsComponent>();
+        RenderComponent* rcs = chunk.Column<RenderComponent>();
+        for(int32_t i = 0; i < chunk.count; ++i)
+        {
+            rcs[i].m_matrix = pcs[i].GetTransform();
+        }
+    }
     void Init()
     {
         ms_world.setGravity(btVector3(0.0f, -9.81f, 0.0f));
+        Systems::Register("SyncTransforms", 
+            MaskOf(CT_Physics), 
+            MaskOf(CT_Render), 
+            SyncTransforms);
     }
     void Update(float dt)
     {
         ms_world.stepSimulation(dt);
-
-        for(const slot* s = Components::begin(); s != Components::end(); ++s)
-        {
-            PhysicsComponent* pc = Components::Get<PhysicsComponent>(*s);
-            RenderComponent* rc = Components::Get<RenderComponent>(*s);
-            if(!pc | !rc)
-            {
-                continue;
-            }
-
-            rc->m_matrix = pc->GetTransform();
-        }
     }
     void Shutdown()
     {
@@ -81,4 +110,15 @@ namespace Physics
             ms_motionStates.Free(static_cast<btDefaultMotionState*>(state));
         }
     }
+    void DestroyBatch(btRigidBody* const* bodies, int32_t count)
+    {
+        ms_world.RemoveBodies(bodies, count);
+        for(int32_t i = 0; i < count; ++i)
+        {
+            btRigidBody* body = bodies[i];
+            ms_shapes.Free(static_cast<btBoxShape*>(body->getCollisionShape()));
+            ms_motionStates.Free(static_cast<btDefaultMotionState*>(body->getMotionState()));
+            ms_bodies.Free(body);
+        }
+    }
 };
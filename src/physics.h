@@ -38,6 +38,8 @@ namespace Physics
     void Shutdown();
     btRigidBody* Create(float mass, const vec3& position, const vec3& extent);
     void Destroy(btRigidBody* body);
+    // bodies must be non-null and distinct
+    void DestroyBatch(btRigidBody* const* bodies, int32_t count);
 };
 
 struct PhysicsComponent
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+#include "macro.h"
+#include "allocator.h"
+#include "array.h"
+
+// keeps producer and consumer state on separate lines to avoid false sharing
+constexpr size_t CacheLineSize = 64;
+
+// single producer, single consumer ring of fixed capacity. one thread may
+// call TryPush and another TryPop concurrently; Init and Reset must not race
+// either. each side caches the other's index and only reloads it when the
+// ring looks full or empty.
+template<typename T, AllocBucket t_bucket = AB_Default>
+struct SpscQueue
+{
+    static_assert(TriviallyRelocatable<T>::value, "SpscQueue copies items with memcpy");
+
+    alignas(CacheLineSize) T*   m_data;
+    uint32_t                    m_mask;
+
+    alignas(CacheLineSize) std::atomic<uint32_t> m_head;
+    uint32_t                    m_cachedTail;
+
+    alignas(CacheLineSize) std::atomic<uint32_t> m_tail;
+    uint32_t                    m_cachedHead;
+
+    inline SpscQueue()
+    {
+        m_data = nullptr;
+        m_mask = 0u;
+        m_head.store(0u, std::memory_order_relaxed);
+        m_tail.store(0u, std::memory_order_relaxed);
+        m_cachedTail = 0u;
+        m_cachedHead = 0u;
+    }
+    ~SpscQueue()
+    {
+        Reset();
+    }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // capacity is rounded up to a power of two
+    inline void Init(uint32_t capacity)
+    {
+        Reset();
+        uint32_t cap = 2u;
+        while(cap < capacity)
+        {
+            cap <<= 1;
+        }
+        m_data = (T*)Allocator::Alloc(t_bucket, sizeof(T) * cap);
+        m_mask = cap - 1u;
+    }
+    inline void Reset()
+    {
+        Allocator::Free(t_bucket, m_data);
+        m_data = nullptr;
+        m_mask = 0u;
+        m_head.store(0u, std::memory_order_relaxed);
+        m_tail.store(0u, std::memory_order_relaxed);
+        m_cachedTail = 0u;
+        m_cachedHead = 0u;
+    }
+    inline uint32_t Capacity() const
+    {
+        return m_data ? m_mask + 1u : 0u;
+    }
+    // approximate while either side is running
+    inline uint32_t Count() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    // producer side
+    inline bool TryPush(const T& item)
+    {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if(tail - m_cachedHead > m_mask)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if(tail - m_cachedHead > m_mask)
+            {
+                return false;
+            }
+        }
+        memcpy(m_data + (tail & m_mask), &item, sizeof(T));
+        m_tail.store(tail + 1u, std::memory_order_release);
+        return true;
+    }
+    // consumer side
+    inline bool TryPop(T& item)
+    {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        if(head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if(head == m_cachedTail)
+            {
+                return false;
+            }
+        }
+        memcpy(&item, m_data + (head & m_mask), sizeof(T));
+        m_head.store(head + 1u, std::memory_order_release);
+        return true;
+    }
+};
+
+// bounded multi producer, multi consumer queue after Dmitry Vyukov's design.
+// each cell carries a sequence number that tells producers and consumers
+// whether it is free for the current lap, so the only contended writes are
+// the CAS on the head or tail index. never blocks; callers spin or back off.
+template<typename T, AllocBucket t_bucket = AB_Default>
+struct MpmcQueue
+{
+    static_assert(TriviallyRelocatable<T>::value, "MpmcQueue copies items with memcpy");
+
+    struct Cell
+    {
+        std::atomic<uint32_t>   sequence;
+        T                       item;
+    };
+
+    alignas(CacheLineSize) Cell*    m_cells;
+    uint32_t                        m_mask;
+
+    alignas(CacheLineSize) std::atomic<uint32_t> m_tail;
+    alignas(CacheLineSize) std::atomic<uint32_t> m_head;
+    uint8_t                         m_pad[CacheLineSize - sizeof(std::atomic<uint32_t>)];
+
+    inline MpmcQueue()
+    {
+        m_cells = nullptr;
+        m_mask = 0u;
+        m_tail.store(0u, std::memory_order_relaxed);
+        m_head.store(0u, std::memory_order_relaxed);
+    }
+    ~MpmcQueue()
+    {
+        Reset();
+    }
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // capacity is rounded up to a power of two
+    inline void Init(uint32_t capacity)
+    {
+        Reset();
+        uint32_t cap = 2u;
+        while(cap < capacity)
+        {
+            cap <<= 1;
+        }
+        m_cells = (Cell*)Allocator::Alloc(t_bucket, sizeof(Cell) * cap);
+        for(uint32_t i = 0u; i < cap; ++i)
+        {
+            new (&m_cells[i].sequence) std::atomic<uint32_t>(i);
+        }
+        m_mask = cap - 1u;
+    }
+    inline void Reset()
+    {
+        Allocator::Free(t_bucket, m_cells);
+        m_cells = nullptr;
+        m_mask = 0u;
+        m_tail.store(0u, std::memory_order_relaxed);
+        m_head.store(0u, std::memory_order_relaxed);
+    }
+    inline uint32_t Capacity() const
+    {
+        return m_cells ? m_mask + 1u : 0u;
+    }
+    // approximate while other threads are running
+    inline uint32_t Count() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    inline bool TryPush(const T& item)
+    {
+        uint32_t pos = m_tail.load(std::memory_order_relaxed);
+        while(true)
+        {
+            Cell& cell = m_cells[pos & m_mask];
+            const uint32_t seq = cell.sequence.load(std::memory_order_acquire);
+            const int32_t diff = (int32_t)(seq - pos);
+            if(diff == 0)
+            {
+                if(m_tail.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed))
+                {
+                    memcpy(&cell.item, &item, sizeof(T));
+                    cell.sequence.store(pos + 1u, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                // the cell still holds last lap's item: full
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    inline bool TryPop(T& item)
+    {
+        uint32_t pos = m_head.load(std::memory_order_relaxed);
+        while(true)
+        {
+            Cell& cell = m_cells[pos & m_mask];
+            const uint32_t seq = cell.sequence.load(std::memory_order_acquire);
+            const int32_t diff = (int32_t)(seq - (pos + 1u));
+            if(diff == 0)
+            {
+                if(m_head.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed))
+                {
+                    memcpy(&item, &cell.item, sizeof(T));
+                    cell.sequence.store(pos + m_mask + 1u, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                // nothing published in this cell yet: empty
+                return false;
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
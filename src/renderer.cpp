@@ -8,6 +8,7 @@
 #include "ui.h"
 #include "camera.h"
 #include "shaders/ibl.h"
+#include "name.h"
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -57,6 +58,37 @@ GLShader        prefilterShader;
 GLShader        brdfShader;
 GLShader        backgroundShader;
 
+// per draw uniforms, interned in Init so draws skip the string hashing
+struct UniformNames
+{
+    NameId MVP;
+    NameId M;
+    NameId Eye;
+    NameId LightDir;
+    NameId LightRad;
+    NameId Albedo;
+    NameId Roughness;
+    NameId Metalness;
+    NameId Seed;
+    NameId Pal0;
+    NameId Pal1;
+    NameId Pal2;
+    NameId PalCenter;
+    NameId RoughnessOffset;
+    NameId MetalnessOffset;
+    NameId projection;
+    NameId view;
+    NameId irradianceMap;
+    NameId prefilterMap;
+    NameId brdfLUT;
+    NameId MatTex;
+    NameId NorTex;
+    NameId environmentMap;
+    NameId equirectangularMap;
+    NameId roughness;
+};
+UniformNames    ms_names;
+
 void InitCube();
 void InitQuad();
 void RenderCube();
@@ -105,6 +137,33 @@ void Renderer::Init()
     InitCube();
     InitQuad();
 
+    // intern uniform names
+    ms_names.MVP = Names::Intern("MVP");
+    ms_names.M = Names::Intern("M");
+    ms_names.Eye = Names::Intern("Eye");
+    ms_names.LightDir = Names::Intern("LightDir");
+    ms_names.LightRad = Names::Intern("LightRad");
+    ms_names.Albedo = Names::Intern("Albedo");
+    ms_names.Roughness = Names::Intern("Roughness");
+    ms_names.Metalness = Names::Intern("Metalness");
+    ms_names.Seed = Names::Intern("Seed");
+    ms_names.Pal0 = Names::Intern("Pal0");
+    ms_names.Pal1 = Names::Intern("Pal1");
+    ms_names.Pal2 = Names::Intern("Pal2");
+    ms_names.PalCenter = Names::Intern("PalCenter");
+    ms_names.RoughnessOffset = Names::Intern("RoughnessOffset");
+    ms_names.MetalnessOffset = Names::Intern("MetalnessOffset");
+    ms_names.projection = Names::Intern("projection");
+    ms_names.view = Names::Intern("view");
+    ms_names.irradianceMap = Names::Intern("irradianceMap");
+    ms_names.prefilterMap = Names::Intern("prefilterMap");
+    ms_names.brdfLUT = Names::Intern("brdfLUT");
+    ms_names.MatTex = Names::Intern("MatTex");
+    ms_names.NorTex = Names::Intern("NorTex");
+    ms_names.environmentMap = Names::Intern("environmentMap");
+    ms_names.equirectangularMap = Names::Intern("equirectangularMap");
+    ms_names.roughness = Names::Intern("roughness");
+
     // setup shaders
     flatShader.Init(flat_vs, flat_fs);
     texturedShader.Init(textured_vs, textured_fs);
@@ -115,19 +174,19 @@ void Renderer::Init()
     backgroundShader.Init(background_vs, background_fs);
 
     flatShader.Use();
-    flatShader.SetInt("irradianceMap", 0);
-    flatShader.SetInt("prefilterMap", 1);
-    flatShader.SetInt("brdfLUT", 2);
+    flatShader.SetInt(ms_names.irradianceMap, 0);
+    flatShader.SetInt(ms_names.prefilterMap, 1);
+    flatShader.SetInt(ms_names.brdfLUT, 2);
 
     texturedShader.Use();
-    texturedShader.SetInt("irradianceMap", 0);
-    texturedShader.SetInt("prefilterMap", 1);
-    texturedShader.SetInt("brdfLUT", 2);
-    texturedShader.SetInt("MatTex", 3);
-    texturedShader.SetInt("NorTex", 4);
+    texturedShader.SetInt(ms_names.irradianceMap, 0);
+    texturedShader.SetInt(ms_names.prefilterMap, 1);
+    texturedShader.SetInt(ms_names.brdfLUT, 2);
+    texturedShader.SetInt(ms_names.MatTex, 3);
+    texturedShader.SetInt(ms_names.NorTex, 4);
 
     backgroundShader.Use();
-    backgroundShader.SetInt("environmentMap", 0);
+    backgroundShader.SetInt(ms_names.environmentMap, 0);
 
     // setup framebuffer; these are persistent
     glGenFramebuffers(1, &ms_captureFBO); DebugGL();
@@ -205,8 +264,8 @@ EnvironmentMap CreateEnvironmentMap(const char* hdrmap)
 
     // convert hdr env map to cubemap
     rect2CMShader.Use();
-    rect2CMShader.SetInt("equirectangularMap", 0);
-    rect2CMShader.SetMat4("projection", captureProjection);
+    rect2CMShader.SetInt(ms_names.equirectangularMap, 0);
+    rect2CMShader.SetMat4(ms_names.projection, captureProjection);
     glActiveTexture(GL_TEXTURE0); DebugGL();
     glBindTexture(GL_TEXTURE_2D, hdrTexture); DebugGL();
     
@@ -218,7 +277,7 @@ EnvironmentMap CreateEnvironmentMap(const char* hdrmap)
     glViewport(0, 0, cubemapScale, cubemapScale); DebugGL();
     for(uint32_t i = 0; i < NumFaces; ++i)
     {
-        rect2CMShader.SetMat4("view", captureViews[i]);
+        rect2CMShader.SetMat4(ms_names.view, captureViews[i]);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, map.m_environmentMap, 0); DebugGL();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); DebugGL();
@@ -252,8 +311,8 @@ EnvironmentMap CreateEnvironmentMap(const char* hdrmap)
 
     // solve diffuse integral for irradiance cubemap
     irradianceShader.Use();
-    irradianceShader.SetInt("environmentMap", 0);
-    irradianceShader.SetMat4("projection", captureProjection);
+    irradianceShader.SetInt(ms_names.environmentMap, 0);
+    irradianceShader.SetMat4(ms_names.projection, captureProjection);
     glActiveTexture(GL_TEXTURE0); DebugGL();
     glBindTexture(GL_TEXTURE_CUBE_MAP, map.m_environmentMap); DebugGL();
 
@@ -261,7 +320,7 @@ EnvironmentMap CreateEnvironmentMap(const char* hdrmap)
     glBindFramebuffer(GL_FRAMEBUFFER, ms_captureFBO); DebugGL();
     for(uint32_t i = 0; i < NumFaces; ++i)
     {
-        irradianceShader.SetMat4("view", captureViews[i]);
+        irradianceShader.SetMat4(ms_names.view, captureViews[i]);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, map.m_irradianceMap, 0); DebugGL();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); DebugGL();
@@ -287,8 +346,8 @@ EnvironmentMap CreateEnvironmentMap(const char* hdrmap)
 
     // run a quasi monte-carlo sim on the environment lighting to create a prefilter cubemap
     prefilterShader.Use();
-    prefilterShader.SetInt("environmentMap", 0);
-    prefilterShader.SetMat4("projection", captureProjection);
+    prefilterShader.SetInt(ms_names.environmentMap, 0);
+    prefilterShader.SetMat4(ms_names.projection, captureProjection);
     glActiveTexture(GL_TEXTURE0); DebugGL();
     glBindTexture(GL_TEXTURE_CUBE_MAP, map.m_environmentMap); DebugGL();
 
@@ -301,10 +360,10 @@ EnvironmentMap CreateEnvironmentMap(const char* hdrmap)
         glViewport(0, 0, mipWidth, mipWidth); DebugGL();
 
         float roughness = (float)mip / (float)(maxMipLevels - 1);
-        prefilterShader.SetFloat("roughness", roughness);
+        prefilterShader.SetFloat(ms_names.roughness, roughness);
         for(uint32_t i = 0; i < NumFaces; ++i)
         {
-            prefilterShader.SetMat4("view", captureViews[i]);
+            prefilterShader.SetMat4(ms_names.view, captureViews[i]);
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 
                 GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, map.m_prefilterMap, mip); DebugGL();
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); DebugGL();
@@ -426,8 +485,8 @@ void Renderer::DrawBackground()
 {
     const Camera* cam = Camera::GetActive();
     backgroundShader.Use();
-    backgroundShader.SetMat4("projection", cam->P);
-    backgroundShader.SetMat4("view", cam->V);
+    backgroundShader.SetMat4(ms_names.projection, cam->P);
+    backgroundShader.SetMat4(ms_names.view, cam->V);
     glActiveTexture(GL_TEXTURE0 + 0); DebugGL();
     glBindTexture(GL_TEXTURE_CUBE_MAP, ms_envmap.m_environmentMap); DebugGL();
     //glBindTexture(GL_TEXTURE_CUBE_MAP, ms_envmap.m_irradianceMap); // display irradiance map
@@ -472,18 +531,18 @@ void Renderer::DrawTextured(
     const Textured::FSUniform&  fsuni)
 {
     texturedShader.Use();
-    texturedShader.SetMat4("MVP", vsuni.MVP);
-    texturedShader.SetMat4("M", vsuni.M);
-    texturedShader.SetVec3("Eye", fsuni.Eye);
-    texturedShader.SetVec3("LightDir", fsuni.LightDir);
-    texturedShader.SetFloat("LightRad", fsuni.LightRad);
-    texturedShader.SetVec3("Pal0", fsuni.Pal0);
-    texturedShader.SetVec3("Pal1", fsuni.Pal1);
-    texturedShader.SetVec3("Pal2", fsuni.Pal2);
-    texturedShader.SetFloat("PalCenter", fsuni.PalCenter);
-    texturedShader.SetFloat("RoughnessOffset", fsuni.RoughnessOffset);
-    texturedShader.SetFloat("MetalnessOffset", fsuni.MetalnessOffset);
-    texturedShader.SetFloat("Seed", fsuni.Seed);
+    texturedShader.SetMat4(ms_names.MVP, vsuni.MVP);
+    texturedShader.SetMat4(ms_names.M, vsuni.M);
+    texturedShader.SetVec3(ms_names.Eye, fsuni.Eye);
+    texturedShader.SetVec3(ms_names.LightDir, fsuni.LightDir);
+    texturedShader.SetFloat(ms_names.LightRad, fsuni.LightRad);
+    texturedShader.SetVec3(ms_names.Pal0, fsuni.Pal0);
+    texturedShader.SetVec3(ms_names.Pal1, fsuni.Pal1);
+    texturedShader.SetVec3(ms_names.Pal2, fsuni.Pal2);
+    texturedShader.SetFloat(ms_names.PalCenter, fsuni.PalCenter);
+    texturedShader.SetFloat(ms_names.RoughnessOffset, fsuni.RoughnessOffset);
+    texturedShader.SetFloat(ms_names.MetalnessOffset, fsuni.MetalnessOffset);
+    texturedShader.SetFloat(ms_names.Seed, fsuni.Seed);
 
     glActiveTexture(GL_TEXTURE0 + 3); DebugGL();
     glBindTexture(GL_TEXTURE_2D, mat.id); DebugGL();
@@ -499,15 +558,15 @@ void Renderer::DrawFlat(
     const Flat::FSUniform& fsuni)
 {
     flatShader.Use();
-    flatShader.SetMat4("MVP", vsuni.MVP);
-    flatShader.SetMat4("M", vsuni.M);
-    flatShader.SetVec3("Eye", fsuni.Eye);
-    flatShader.SetVec3("LightDir", fsuni.LightDir);
-    flatShader.SetVec3("Albedo", fsuni.Albedo);
-    flatShader.SetFloat("LightRad", fsuni.LightRad);
-    flatShader.SetFloat("Roughness", fsuni.Roughness);
-    flatShader.SetFloat("Metalness", fsuni.Metalness);
-    flatShader.SetFloat("Seed", fsuni.Seed);
+    flatShader.SetMat4(ms_names.MVP, vsuni.MVP);
+    flatShader.SetMat4(ms_names.M, vsuni.M);
+    flatShader.SetVec3(ms_names.Eye, fsuni.Eye);
+    flatShader.SetVec3(ms_names.LightDir, fsuni.LightDir);
+    flatShader.SetVec3(ms_names.Albedo, fsuni.Albedo);
+    flatShader.SetFloat(ms_names.LightRad, fsuni.LightRad);
+    flatShader.SetFloat(ms_names.Roughness, fsuni.Roughness);
+    flatShader.SetFloat(ms_names.Metalness, fsuni.Metalness);
+    flatShader.SetFloat(ms_names.Seed, fsuni.Seed);
 
     Draw(buffer);
 }
@@ -3,7 +3,6 @@
 #include <stdio.h>
 #include "macro.h"
 #include "glad.h"
-#include "fnv.h"
 
 enum ErrorCheckType
 {
@@ -47,6 +46,7 @@ void CheckCompileErrors(uint32_t id, ErrorCheckType type)
 void GLShader::Init(const char* vs, const char* fs)
 {
     m_id = 0;
+    m_uniforms.Clear();
 
     DebugGL();
     uint32_t vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -78,6 +78,7 @@ void GLShader::Shutdown()
     glDeleteProgram(m_id);
     DebugGL();
     m_id = 0;
+    m_uniforms.Reset();
 }
 void GLShader::Use()
 {
@@ -88,56 +89,50 @@ void GLShader::Use()
         DebugGL();
     }
 }
-void GLShader::SetInt(const char* name, int32_t value)
+void GLShader::SetInt(NameId name, int32_t value)
 {
     glUniform1i(GetUniformLocation(name), value);
     DebugGL();
 }
-void GLShader::SetFloat(const char* name, float value)
+void GLShader::SetFloat(NameId name, float value)
 {
     glUniform1f(GetUniformLocation(name), value);
     DebugGL();
 }
-void GLShader::SetVec2(const char* name, const vec2& value)
+void GLShader::SetVec2(NameId name, const vec2& value)
 {
     glUniform2fv(GetUniformLocation(name), 1, &value[0]);
     DebugGL();
 }
-void GLShader::SetVec3(const char* name, const vec3& value)
+void GLShader::SetVec3(NameId name, const vec3& value)
 {
     glUniform3fv(GetUniformLocation(name), 1, &value[0]);
     DebugGL();
 }
-void GLShader::SetVec4(const char* name, const vec4& value)
+void GLShader::SetVec4(NameId name, const vec4& value)
 {
     glUniform4fv(GetUniformLocation(name), 1, &value[0]);
     DebugGL();
 }
-void GLShader::SetMat3(const char* name, const mat3& value)
+void GLShader::SetMat3(NameId name, const mat3& value)
 {
     glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, &value[0][0]);
     DebugGL();
 }
-void GLShader::SetMat4(const char* name, const mat4& value)
+void GLShader::SetMat4(NameId name, const mat4& value)
 {
     glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &value[0][0]);
     DebugGL();
 }
-int32_t GLShader::GetUniformLocation(const char* name)
+int32_t GLShader::GetUniformLocation(NameId name)
 {
-    uint64_t hash = Fnv64(name);
-    int32_t idx = m_uniforms.find({ -1, hash });
-    if(idx == -1)
+    bool added;
+    int32_t& loc = m_uniforms.FindOrAdd(name, added);
+    if(added)
     {
-        idx = m_uniforms.count();
-        int32_t loc = glGetUniformLocation(m_id, name);
+        loc = glGetUniformLocation(m_id, Names::GetString(name));
         DebugGL();
         //Assert(loc != -1); // Sometimes deadstripped by linker
-        m_uniforms.grow() = 
-        {
-            loc,
-            hash
-        };
     }
-    return m_uniforms[idx].location;
+    return loc;
 }
@@ -1,42 +1,431 @@
 #pragma once
 
+#include <stdint.h>
+#include <string.h>
+
 #include "swap.h"
+#include "macro.h"
+#include "allocator.h"
+#include "task.h"
 
-template<typename T>
-static void Sort(T* x, int32_t len)
+struct DefaultLess
 {
-    if(len <= 8)
+    template<typename T>
+    inline bool operator()(const T& a, const T& b) const
     {
-        for(int32_t i = 0; i < len; ++i)
+        return a < b;
+    }
+};
+
+template<typename T, typename L>
+static void InsertionSort(T* x, int32_t len, L less)
+{
+    for(int32_t i = 1; i < len; ++i)
+    {
+        for(int32_t j = i; j > 0 && less(x[j], x[j - 1]); --j)
+        {
+            Swap(x[j], x[j - 1]);
+        }
+    }
+}
+
+template<typename T, typename L>
+static void SiftDown(T* x, int32_t root, int32_t len, L less)
+{
+    while(true)
+    {
+        int32_t child = root * 2 + 1;
+        if(child >= len)
+        {
+            return;
+        }
+        if(child + 1 < len && less(x[child], x[child + 1]))
+        {
+            ++child;
+        }
+        if(!less(x[root], x[child]))
+        {
+            return;
+        }
+        Swap(x[root], x[child]);
+        root = child;
+    }
+}
+
+template<typename T, typename L>
+static void HeapSort(T* x, int32_t len, L less)
+{
+    for(int32_t i = len / 2 - 1; i >= 0; --i)
+    {
+        SiftDown(x, i, len, less);
+    }
+    for(int32_t i = len - 1; i > 0; --i)
+    {
+        Swap(x[0], x[i]);
+        SiftDown(x, 0, i, less);
+    }
+}
+
+template<typename T, typename L>
+static void IntroSort(T* x, int32_t len, int32_t depth, L less)
+{
+    while(len > 16)
+    {
+        if(depth-- == 0)
+        {
+            HeapSort(x, len, less);
+            return;
+        }
+
+        // median of three moves the pivot to the front, bounding both scans
+        {
+            const int32_t m = len / 2;
+            if(less(x[m], x[0]))
+            {
+                Swap(x[m], x[0]);
+            }
+            if(less(x[len - 1], x[0]))
+            {
+                Swap(x[len - 1], x[0]);
+            }
+            if(less(x[len - 1], x[m]))
+            {
+                Swap(x[len - 1], x[m]);
+            }
+            Swap(x[0], x[m]);
+        }
+
+        int32_t i = 0;
+        int32_t j = len;
+        while(true)
         {
-            int32_t c = i;
-            for(int32_t j = i + 1; j < len; ++j)
+            while(less(x[++i], x[0]));
+            while(less(x[0], x[--j]));
+            if(i >= j)
             {
-                if(x[j] < x[c])
-                {
-                    c = j;
-                }
+                break;
             }
-            Swap(x[c], x[i]);
+            Swap(x[i], x[j]);
+        }
+        Swap(x[0], x[j]);
+
+        // recurse into the smaller side to bound stack depth
+        if(j < len - j - 1)
+        {
+            IntroSort(x, j, depth, less);
+            x += j + 1;
+            len -= j + 1;
         }
+        else
+        {
+            IntroSort(x + j + 1, len - j - 1, depth, less);
+            len = j;
+        }
+    }
+    InsertionSort(x, len, less);
+}
+
+// introsort: quicksort that falls back to heapsort past 2 log2(len) levels
+template<typename T, typename L = DefaultLess>
+static void Sort(T* x, int32_t len, L less = L())
+{
+    int32_t depth = 0;
+    for(int32_t n = len; n > 1; n >>= 1)
+    {
+        depth += 2;
+    }
+    IntroSort(x, len, depth, less);
+}
+
+// maps a key to an unsigned integer with the same ordering
+template<typename K>
+struct RadixKey;
+
+template<>
+struct RadixKey<uint32_t>
+{
+    typedef uint32_t Bits;
+    static inline Bits Get(uint32_t x) { return x; }
+};
+
+template<>
+struct RadixKey<uint64_t>
+{
+    typedef uint64_t Bits;
+    static inline Bits Get(uint64_t x) { return x; }
+};
+
+template<>
+struct RadixKey<int32_t>
+{
+    typedef uint32_t Bits;
+    static inline Bits Get(int32_t x) { return (uint32_t)x ^ 0x80000000u; }
+};
+
+template<>
+struct RadixKey<int64_t>
+{
+    typedef uint64_t Bits;
+    static inline Bits Get(int64_t x) { return (uint64_t)x ^ 0x8000000000000000ull; }
+};
+
+// negative floats have every bit flipped, positive ones just the sign
+template<>
+struct RadixKey<float>
+{
+    typedef uint32_t Bits;
+    static inline Bits Get(float x)
+    {
+        uint32_t u;
+        memcpy(&u, &x, sizeof(u));
+        return u ^ ((uint32_t)((int32_t)u >> 31) | 0x80000000u);
+    }
+};
+
+template<>
+struct RadixKey<double>
+{
+    typedef uint64_t Bits;
+    static inline Bits Get(double x)
+    {
+        uint64_t u;
+        memcpy(&u, &x, sizeof(u));
+        return u ^ ((uint64_t)((int64_t)u >> 63) | 0x8000000000000000ull);
+    }
+};
+
+template<typename K, typename V>
+static void InsertionSortByKey(K* keys, V* values, int32_t len)
+{
+    for(int32_t i = 1; i < len; ++i)
+    {
+        for(int32_t j = i; j > 0 && RadixKey<K>::Get(keys[j]) < RadixKey<K>::Get(keys[j - 1]); --j)
+        {
+            Swap(keys[j], keys[j - 1]);
+            if(values)
+            {
+                Swap(values[j], values[j - 1]);
+            }
+        }
+    }
+}
+
+// stable LSD radix sort of keys, one byte per pass, carrying values along.
+// values may be null. passes where every key has the same byte are skipped.
+// scratch comes from the calling thread's temp arena.
+template<typename K, typename V>
+static void SortByKey(K* keys, V* values, int32_t len)
+{
+    typedef RadixKey<K> Key;
+    constexpr int32_t Passes = sizeof(typename Key::Bits);
+
+    if(len <= 64)
+    {
+        InsertionSortByKey(keys, values, len);
         return;
     }
 
-    int32_t i, j;
+    TempScope scope;
+    K* tempKeys = (K*)Allocator::Alloc(AB_Temp, sizeof(K) * len);
+    V* tempValues = values ? (V*)Allocator::Alloc(AB_Temp, sizeof(V) * len) : nullptr;
+
+    uint32_t counts[Passes][256];
+    MemZero(counts);
+    for(int32_t i = 0; i < len; ++i)
     {
-        const int32_t p = len / 2;
-        for(i = 0, j = len - 1; ; ++i, --j)
+        const typename Key::Bits bits = Key::Get(keys[i]);
+        for(int32_t p = 0; p < Passes; ++p)
         {
-            while(x[i] < x[p]) ++i;
-            while(x[j] > x[p]) --j;
+            ++counts[p][(bits >> (p * 8)) & 0xff];
+        }
+    }
 
-            if(i >= j) 
-                break;
+    K* srcKeys = keys;
+    V* srcValues = values;
+    K* dstKeys = tempKeys;
+    V* dstValues = tempValues;
+    for(int32_t p = 0; p < Passes; ++p)
+    {
+        const int32_t shift = p * 8;
+        uint32_t* count = counts[p];
+        if(count[(Key::Get(srcKeys[0]) >> shift) & 0xff] == (uint32_t)len)
+        {
+            continue;
+        }
+        uint32_t offset = 0u;
+        for(int32_t b = 0; b < 256; ++b)
+        {
+            const uint32_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for(int32_t i = 0; i < len; ++i)
+        {
+            const uint32_t dst = count[(Key::Get(srcKeys[i]) >> shift) & 0xff]++;
+            dstKeys[dst] = srcKeys[i];
+            if(values)
+            {
+                dstValues[dst] = srcValues[i];
+            }
+        }
+        // plain pointer swaps; Swap is for values
+        K* keyTmp = srcKeys;
+        srcKeys = dstKeys;
+        dstKeys = keyTmp;
+        V* valueTmp = srcValues;
+        srcValues = dstValues;
+        dstValues = valueTmp;
+    }
 
-            Swap(x[i], x[j]);
+    if(srcKeys != keys)
+    {
+        Copy(keys, srcKeys, len);
+        if(values)
+        {
+            Copy(values, srcValues, len);
         }
     }
+}
 
-    Sort(x, i);
-    Sort(x + i, len - i);
+template<typename K>
+static void SortByKey(K* keys, int32_t len)
+{
+    SortByKey(keys, (uint8_t*)nullptr, len);
+}
+
+template<typename K, typename V>
+struct RadixJob
+{
+    static constexpr int32_t Chunks = 16;
+
+    const K*    srcKeys;
+    const V*    srcValues;
+    K*          dstKeys;
+    V*          dstValues;
+    int32_t     len;
+    int32_t     chunkLen;
+    int32_t     shift;
+    uint32_t    counts[Chunks][256];
+
+    static void Count(Task* task)
+    {
+        RadixJob& job = *(RadixJob*)task->mem[0];
+        const int32_t chunk = (int32_t)task->mem[1];
+        const int32_t begin = chunk * job.chunkLen;
+        const int32_t end = Min(begin + job.chunkLen, job.len);
+        uint32_t* count = job.counts[chunk];
+        memset(count, 0, sizeof(job.counts[chunk]));
+        for(int32_t i = begin; i < end; ++i)
+        {
+            ++count[(RadixKey<K>::Get(job.srcKeys[i]) >> job.shift) & 0xff];
+        }
+    }
+    static void Scatter(Task* task)
+    {
+        RadixJob& job = *(RadixJob*)task->mem[0];
+        const int32_t chunk = (int32_t)task->mem[1];
+        const int32_t begin = chunk * job.chunkLen;
+        const int32_t end = Min(begin + job.chunkLen, job.len);
+        uint32_t* offset = job.counts[chunk];
+        for(int32_t i = begin; i < end; ++i)
+        {
+            const uint32_t dst = offset[(RadixKey<K>::Get(job.srcKeys[i]) >> job.shift) & 0xff]++;
+            job.dstKeys[dst] = job.srcKeys[i];
+            if(job.srcValues)
+            {
+                job.dstValues[dst] = job.srcValues[i];
+            }
+        }
+    }
+    void Run(void (*fn)(Task*))
+    {
+        for(int32_t c = 0; c < Chunks; ++c)
+        {
+            Task task;
+            task.fn = fn;
+            task.mem[0] = (uint64_t)(uintptr_t)this;
+            task.mem[1] = (uint64_t)c;
+            TaskManager::Add(TT_General, task);
+        }
+        TaskManager::Start(TT_General, 1);
+    }
+};
+
+// SortByKey spread over the task threads: each pass counts and scatters
+// fixed chunks in parallel, with the prefix sum done on the calling thread.
+// must be called from the thread that owns TaskManager, outside of a task.
+template<typename K, typename V>
+static void ParallelSortByKey(K* keys, V* values, int32_t len)
+{
+    typedef RadixJob<K, V> Job;
+    constexpr int32_t Passes = sizeof(typename RadixKey<K>::Bits);
+    constexpr int32_t MinParallel = 1 << 16;
+
+    if(len < MinParallel)
+    {
+        SortByKey(keys, values, len);
+        return;
+    }
+
+    TempScope scope;
+    K* tempKeys = (K*)Allocator::Alloc(AB_Temp, sizeof(K) * len);
+    V* tempValues = values ? (V*)Allocator::Alloc(AB_Temp, sizeof(V) * len) : nullptr;
+    Job& job = *(Job*)Allocator::Alloc(AB_Temp, sizeof(Job));
+    job.len = len;
+    job.chunkLen = (len + Job::Chunks - 1) / Job::Chunks;
+
+    K* srcKeys = keys;
+    V* srcValues = values;
+    K* dstKeys = tempKeys;
+    V* dstValues = tempValues;
+    for(int32_t p = 0; p < Passes; ++p)
+    {
+        job.srcKeys = srcKeys;
+        job.srcValues = srcValues;
+        job.dstKeys = dstKeys;
+        job.dstValues = dstValues;
+        job.shift = p * 8;
+        job.Run(Job::Count);
+
+        uint32_t offset = 0u;
+        bool skip = false;
+        for(int32_t b = 0; b < 256 && !skip; ++b)
+        {
+            for(int32_t c = 0; c < Job::Chunks; ++c)
+            {
+                const uint32_t count = job.counts[c][b];
+                job.counts[c][b] = offset;
+                offset += count;
+            }
+            // every key landed in one bucket
+            skip = offset == (uint32_t)len && job.counts[0][b] == 0u;
+        }
+        if(skip)
+        {
+            continue;
+        }
+        job.Run(Job::Scatter);
+        // plain pointer swaps; Swap is for values
+        K* keyTmp = srcKeys;
+        srcKeys = dstKeys;
+        dstKeys = keyTmp;
+        V* valueTmp = srcValues;
+        srcValues = dstValues;
+        dstValues = valueTmp;
+    }
+
+    if(srcKeys != keys)
+    {
+        Copy(keys, srcKeys, len);
+        if(values)
+        {
+            Copy(values, srcValues, len);
+        }
+    }
+}
+
+template<typename K>
+static void ParallelSortByKey(K* keys, int32_t len)
+{
+    ParallelSortByKey(keys, (uint8_t*)nullptr, len);
 }
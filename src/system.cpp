@@ -0,0 +1,119 @@
+#include "system.h"
+
+#include "array.h"
+#include "macro.h"
+#include "task.h"
+#include "command.h"
+
+struct System
+{
+    const char*     m_name;
+    ComponentMask   m_reads;
+    ComponentMask   m_writes;
+    SystemFn        m_fn;
+    int32_t         m_wave;
+};
+
+// one chunk of one system
+struct SystemWork
+{
+    const System*   m_system;
+    ComponentChunk  m_chunk;
+    // orders the commands this work records
+    uint32_t        m_order;
+};
+
+namespace Systems
+{
+    Array<System>       ms_systems;
+    Array<SystemWork>   ms_work;
+    int32_t             ms_waveCount = 0;
+    float               ms_dt = 0.0f;
+
+    inline bool Conflicts(const System& a, const System& b)
+    {
+        return (a.m_writes & (b.m_reads | b.m_writes)) != 0u ||
+            (b.m_writes & a.m_reads) != 0u;
+    }
+    int32_t Register(const char* name, ComponentMask reads, ComponentMask writes, SystemFn fn)
+    {
+        const int32_t idx = ms_systems.count();
+        System& sys = ms_systems.grow();
+        sys.m_name = name;
+        sys.m_reads = reads;
+        sys.m_writes = writes;
+        sys.m_fn = fn;
+        sys.m_wave = 0;
+        for(int32_t i = 0; i < idx; ++i)
+        {
+            if(Conflicts(ms_systems[i], sys))
+            {
+                sys.m_wave = Max(sys.m_wave, ms_systems[i].m_wave + 1);
+            }
+        }
+        ms_waveCount = Max(ms_waveCount, sys.m_wave + 1);
+        return idx;
+    }
+    void RunWork(Task* task)
+    {
+        const SystemWork& work = *(const SystemWork*)task->mem[0];
+        Commands::SetOrder(work.m_order);
+        work.m_system->m_fn(work.m_chunk, ms_dt);
+        // the pool thread may record for something else next
+        Commands::SetOrder(0u);
+    }
+    void GatherChunk(const ComponentChunk& chunk, void* data)
+    {
+        SystemWork& work = ms_work.grow();
+        work.m_system = (const System*)data;
+        work.m_chunk = chunk;
+        // work is gathered system by system in registration order, then
+        // chunk by chunk, so this is stable from run to run. 0 is left for
+        // commands recorded outside systems.
+        work.m_order = (uint32_t)ms_work.count();
+    }
+    void Update(float dt)
+    {
+        ms_dt = dt;
+        for(int32_t wave = 0; wave < ms_waveCount; ++wave)
+        {
+            ms_work.clear();
+            for(const System& sys : ms_systems)
+            {
+                if(sys.m_wave == wave)
+                {
+                    Components::ForEachChunk(sys.m_reads | sys.m_writes, GatherChunk, (void*)&sys);
+                }
+            }
+
+            // waking the pool costs more than a lone chunk
+            if(ms_work.count() == 1)
+            {
+                Commands::SetOrder(ms_work[0].m_order);
+                ms_work[0].m_system->m_fn(ms_work[0].m_chunk, dt);
+                Commands::SetOrder(0u);
+            }
+            else if(ms_work.count() > 1)
+            {
+                for(const SystemWork& work : ms_work)
+                {
+                    Task task;
+                    task.fn = RunWork;
+                    task.mem[0] = (uint64_t)(uintptr_t)&work;
+                    TaskManager::Add(TT_General, task);
+                }
+                TaskManager::Start(TT_General, 1);
+            }
+            // the wave barrier is the sync point for structural changes
+            Commands::Playback();
+        }
+    }
+    int32_t WaveCount()
+    {
+        return ms_waveCount;
+    }
+    int32_t GetWave(int32_t system)
+    {
+        return ms_systems[system].m_wave;
+    }
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include "component.h"
+
+// per chunk update; fn may only touch the chunk's columns for types it
+// declared and must not start TaskManager work of its own. structural
+// changes go through Commands, and are applied once the wave finishes.
+typedef void (*SystemFn)(const ComponentChunk& chunk, float dt);
+
+// systems run over every entity holding all of reads | writes. systems are
+// layered into waves in registration order: a system lands in the wave
+// after the last earlier system it conflicts with (one writes what the
+// other reads or writes). each wave's chunks run together on the task
+// threads, so non-conflicting systems and chunks of one system overlap.
+namespace Systems
+{
+    int32_t Register(const char* name, ComponentMask reads, ComponentMask writes, SystemFn fn);
+    void Update(float dt);
+    int32_t WaveCount();
+    int32_t GetWave(int32_t system);
+};
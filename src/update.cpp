@@ -2,6 +2,7 @@
 
 #include "component.h"
 #include "physics.h"
+#include "system.h"
 #include "ui.h"
 #include "allocator.h"
 #include "control.h"
@@ -86,4 +87,5 @@ void Update(float t, float dt)
         cam->yaw(yaw * dt);
     }
     Physics::Update(dt);
+    Systems::Update(dt);
 }
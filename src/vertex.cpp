@@ -1,6 +1,6 @@
 
 #include "vertex.h"
-#include "dict.h"
+#include "hashmap.h"
 #include "fnv.h"
 
 
@@ -14,23 +14,21 @@ void IndexVertices(
     indout.reserve(verts.count());
     out.reserve(verts.count() / 6);
 
-    TempDict2<uint64_t, int32_t> lookup;
-    lookup.Rehash(verts.count() / 64);
+    // keys are already hashes
+    TempHashMap<uint64_t, int32_t, IdentityHash> lookup;
+    lookup.Reserve(verts.count() / 6);
 
     for(const Vertex& v : verts)
     {
-        uint64_t hash = Fnv64(&v, sizeof(Vertex));
-        int32_t* idx = lookup.Get(hash);
-        if(idx)
+        uint64_t hash = HashPod(v);
+        bool added;
+        int32_t& idx = lookup.FindOrAdd(hash, added);
+        if(added)
         {
-            indout.append() = *idx;
-        }
-        else
-        {
-            lookup.Insert(hash, out.count());
-            indout.append() = out.count();
+            idx = out.count();
             out.grow() = v;
         }
+        indout.append() = idx;
     }
 }
 
@@ -0,0 +1,90 @@
+#include "vmem.h"
+
+#include "macro.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif // _WIN32
+
+namespace VirtualMemory
+{
+#ifdef _WIN32
+    size_t PageSize()
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (size_t)info.dwPageSize;
+    }
+    void* Reserve(size_t bytes)
+    {
+        void* p = VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+        Assert(p);
+        return p;
+    }
+    void Release(void* p, size_t bytes)
+    {
+        if(p)
+        {
+            VirtualFree(p, 0, MEM_RELEASE);
+        }
+    }
+    void Commit(void* p, size_t bytes)
+    {
+        void* q = VirtualAlloc(p, bytes, MEM_COMMIT, PAGE_READWRITE);
+        Assert(q == p);
+    }
+    void Decommit(void* p, size_t bytes)
+    {
+        VirtualFree(p, bytes, MEM_DECOMMIT);
+    }
+    void AdviseHugePages(void* p, size_t bytes)
+    {
+        // large pages need SeLockMemoryPrivilege and an up front commit on windows
+    }
+#else
+    size_t PageSize()
+    {
+        return (size_t)sysconf(_SC_PAGESIZE);
+    }
+    void* Reserve(size_t bytes)
+    {
+        void* p = mmap(
+            nullptr,
+            bytes,
+            PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+            -1,
+            0);
+        Assert(p != MAP_FAILED);
+        return p;
+    }
+    void Release(void* p, size_t bytes)
+    {
+        if(p)
+        {
+            munmap(p, bytes);
+        }
+    }
+    void Commit(void* p, size_t bytes)
+    {
+        int32_t rval = mprotect(p, bytes, PROT_READ | PROT_WRITE);
+        Assert(rval == 0);
+    }
+    void Decommit(void* p, size_t bytes)
+    {
+        madvise(p, bytes, MADV_DONTNEED);
+        mprotect(p, bytes, PROT_NONE);
+    }
+    void AdviseHugePages(void* p, size_t bytes)
+    {
+    #ifdef MADV_HUGEPAGE
+        madvise(p, bytes, MADV_HUGEPAGE);
+    #endif // MADV_HUGEPAGE
+    }
+#endif // _WIN32
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// thin wrapper over the OS virtual memory api.
+// address ranges are reserved up front and backed with pages on demand.
+namespace VirtualMemory
+{
+    size_t PageSize();
+    void* Reserve(size_t bytes);
+    void Release(void* p, size_t bytes);
+    void Commit(void* p, size_t bytes);
+    void Decommit(void* p, size_t bytes);
+    void AdviseHugePages(void* p, size_t bytes);
+};
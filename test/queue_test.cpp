@@ -0,0 +1,160 @@
+#include "queue.h"
+
+#include <stdio.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+
+// stress test for SpscQueue and MpmcQueue. every producer pushes the
+// sequence 0..count-1 tagged with its own id; consumers check that the
+// values add up and that each producer's items come out in the order
+// they went in. exits nonzero on any mismatch.
+
+struct Item
+{
+    uint64_t value;
+    uint64_t producer;
+};
+
+static constexpr uint64_t ItemCount = 1u << 21;
+// small so producers and consumers keep running into full and empty
+static constexpr uint32_t Capacity = 256u;
+
+static double Now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool TestSpsc()
+{
+    SpscQueue<Item> queue;
+    queue.Init(Capacity);
+
+    uint64_t sum = 0u;
+    uint64_t outOfOrder = 0u;
+    const double start = Now();
+    std::thread consumer([&]()
+    {
+        Item item;
+        uint64_t expected = 0u;
+        while(expected < ItemCount)
+        {
+            if(queue.TryPop(item))
+            {
+                outOfOrder += item.value != expected;
+                sum += item.value;
+                ++expected;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for(uint64_t i = 0u; i < ItemCount; ++i)
+    {
+        const Item item = { i, 0u };
+        while(!queue.TryPush(item))
+        {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    const double end = Now();
+
+    const bool ok = sum == ItemCount * (ItemCount - 1u) / 2u && !outOfOrder && !queue.Count();
+    printf("spsc 1P/1C: %s, %llu out of order, %.1f Mitems/s\n",
+        ok ? "ok" : "FAILED",
+        (unsigned long long)outOfOrder,
+        ItemCount / (end - start) / 1e6);
+    return ok;
+}
+
+static bool TestMpmc(int32_t producers, int32_t consumers)
+{
+    MpmcQueue<Item> queue;
+    queue.Init(Capacity);
+
+    const uint64_t perProducer = ItemCount / producers;
+    const uint64_t total = perProducer * producers;
+    std::atomic<uint64_t> sum(0u);
+    std::atomic<uint64_t> popped(0u);
+    std::atomic<uint64_t> outOfOrder(0u);
+    std::atomic<uint64_t> badProducer(0u);
+
+    const double start = Now();
+    std::vector<std::thread> threads;
+    for(int32_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]()
+        {
+            for(uint64_t i = 0u; i < perProducer; ++i)
+            {
+                const Item item = { i, (uint64_t)p };
+                while(!queue.TryPush(item))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for(int32_t c = 0; c < consumers; ++c)
+    {
+        threads.emplace_back([&]()
+        {
+            // one consumer sees any one producer's items in push order
+            std::vector<int64_t> last(producers, -1);
+            Item item;
+            uint64_t localSum = 0u;
+            uint64_t localBad = 0u;
+            uint64_t localUnknown = 0u;
+            while(popped.load(std::memory_order_relaxed) < total)
+            {
+                if(queue.TryPop(item))
+                {
+                    popped.fetch_add(1u, std::memory_order_relaxed);
+                    localSum += item.value;
+                    if(item.producer >= (uint64_t)producers)
+                    {
+                        ++localUnknown;
+                        continue;
+                    }
+                    localBad += (int64_t)item.value <= last[item.producer];
+                    last[item.producer] = (int64_t)item.value;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            sum += localSum;
+            outOfOrder += localBad;
+            badProducer += localUnknown;
+        });
+    }
+    for(std::thread& t : threads)
+    {
+        t.join();
+    }
+    const double end = Now();
+
+    const bool ok = sum.load() == producers * (perProducer * (perProducer - 1u) / 2u) &&
+        !outOfOrder.load() && !badProducer.load() && !queue.Count();
+    printf("mpmc %dP/%dC: %s, %llu out of order, %.1f Mitems/s\n",
+        producers, consumers,
+        ok ? "ok" : "FAILED",
+        (unsigned long long)outOfOrder.load(),
+        total / (end - start) / 1e6);
+    return ok;
+}
+
+int main()
+{
+    bool ok = TestSpsc();
+    ok = TestMpmc(1, 1) && ok;
+    ok = TestMpmc(4, 1) && ok;
+    ok = TestMpmc(1, 4) && ok;
+    ok = TestMpmc(4, 4) && ok;
+    return ok ? 0 : 1;
+}